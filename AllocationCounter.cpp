@@ -0,0 +1,54 @@
+#include "AllocationCounter.h"
+#include <iostream>
+
+using namespace std;
+
+AllocationCounter::AllocationCounter(pmr::memory_resource* upstream)
+    : upstream(upstream), allocations(0), deallocations(0), bytesAllocated(0), bytesInUse(0), peakBytesInUse(0) {
+}
+
+void* AllocationCounter::do_allocate(size_t bytes, size_t alignment) {
+    void* pointer = upstream->allocate(bytes, alignment);
+    allocations++;
+    bytesAllocated += bytes;
+    bytesInUse += bytes;
+    if (bytesInUse > peakBytesInUse) {
+        peakBytesInUse = bytesInUse;
+    }
+    return pointer;
+}
+
+void AllocationCounter::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    upstream->deallocate(pointer, bytes, alignment);
+    deallocations++;
+    bytesInUse -= bytes;
+}
+
+bool AllocationCounter::do_is_equal(const pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+long long AllocationCounter::getAllocationCount() const {
+    return allocations;
+}
+
+long long AllocationCounter::getDeallocationCount() const {
+    return deallocations;
+}
+
+size_t AllocationCounter::getBytesAllocated() const {
+    return bytesAllocated;
+}
+
+size_t AllocationCounter::getBytesInUse() const {
+    return bytesInUse;
+}
+
+size_t AllocationCounter::getPeakBytesInUse() const {
+    return peakBytesInUse;
+}
+
+void AllocationCounter::displayStats() const {
+    cout << "Heap Allocations: " << allocations << " (" << bytesAllocated / 1024 << "KB), "
+        << "Frees: " << deallocations << ", Peak In Use: " << peakBytesInUse / 1024 << "KB" << endl;
+}
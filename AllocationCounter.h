@@ -0,0 +1,35 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstddef>
+#include <memory_resource>
+
+// Memory resource that forwards to an upstream resource and counts the
+// calls. Placed under a pool it counts the pool's trips to the heap, so a
+// flat count over an interval shows the hot path ran allocation-free.
+// Not thread-safe; use one per thread.
+class AllocationCounter : public std::pmr::memory_resource {
+public:
+    AllocationCounter(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+    long long getAllocationCount() const;
+    long long getDeallocationCount() const;
+    size_t getBytesAllocated() const;
+    size_t getBytesInUse() const;
+    size_t getPeakBytesInUse() const;
+    void displayStats() const;
+
+private:
+    std::pmr::memory_resource* upstream;
+    long long allocations;
+    long long deallocations;
+    size_t bytesAllocated;
+    size_t bytesInUse;
+    size_t peakBytesInUse;
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+#endif
@@ -0,0 +1,517 @@
+#include "Benchmark.h"
+#include "PacketClassifier.h"
+#include "IPAddress.h"
+#include "EventQueue.h"
+#include "NetworkSimulator.h"
+#include "Topology.h"
+#include "ForwardingPolicy.h"
+#include "PacketParser.h"
+#include "FlowTable.h"
+#include "ForwardingTable.h"
+#include "RouteUpdateStream.h"
+#include "RoutingTable.h"
+#include "Clock.h"
+#include <iostream>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    // Rule shapes loosely follow published ACL sets: specific sources, a mix
+    // of destination prefix lengths, mostly exact or wildcard ports and a few
+    // common ranges. Only the final catch-all wildcards both addresses.
+    const int SOURCE_LENGTHS[] = { 0, 16, 24, 24, 32, 32 };
+    const int DESTINATION_LENGTHS[] = { 0, 8, 16, 24, 32 };
+    const int PORT_RANGES[][2] = { { 0, 1023 }, { 1024, 65535 }, { 6000, 6063 }, { 49152, 65535 } };
+
+    ClassifierRule randomRule(mt19937& rng) {
+        ClassifierRule rule;
+        do {
+            rule.sourceLength = SOURCE_LENGTHS[rng() % 6];
+            rule.destinationLength = DESTINATION_LENGTHS[rng() % 5];
+        } while (rule.sourceLength == 0 && rule.destinationLength == 0);
+        rule.source = static_cast<uint32_t>(rng());
+        rule.destination = static_cast<uint32_t>(rng());
+
+        uint32_t shape = rng() % 10;
+        if (shape < 3) {
+            rule.portLow = 0;
+            rule.portHigh = 65535;
+        }
+        else if (shape < 8) {
+            rule.portLow = static_cast<int>(rng() % 65536);
+            rule.portHigh = rule.portLow;
+        }
+        else {
+            const int* range = PORT_RANGES[rng() % 4];
+            rule.portLow = range[0];
+            rule.portHigh = range[1];
+        }
+        rule.qosClass = static_cast<int>(rng() % 3);
+        return rule;
+    }
+
+    // Next hop of the flow hashing to address, compared by name so tables
+    // that numbered their groups differently can be checked against each other
+    string forwardedHop(ForwardingTable& fib, uint32_t address) {
+        uint32_t group = fib.lookup(address);
+        if (group == ForwardingTable::NO_ROUTE) {
+            return "";
+        }
+        return fib.getNextHop(fib.recordForward(fib.selectMember(group, address)));
+    }
+
+    // Feeds the packets through the path in bursts, as the driver's loop
+    // does without the printing: enqueue a burst, then dequeue, TTL check
+    // and route until the queues are empty. The checksum covers the order
+    // and the forwarding decisions.
+    template<typename Path>
+    long long forwardBursts(Path& path, const vector<packets>& input, size_t burst, size_t rounds,
+        uint64_t& checksum) {
+        packets packet;
+        checksum = 0;
+        uint64_t position = 0;
+        long long start = Clock::now();
+        for (size_t round = 0; round < rounds; round++) {
+            for (size_t first = 0; first < input.size(); first += burst) {
+                size_t last = first + burst < input.size() ? first + burst : input.size();
+                for (size_t i = first; i < last; i++) {
+                    packet = input[i];
+                    path.enqueuePacket(packet, 0);
+                }
+                while (path.dequeuePacket(packet, 0)) {
+                    packet.decrementTTL();
+                    uint32_t member = packet.getTTL() > 0 ? path.routePacket(packet, 0) : ForwardingTable::NO_ROUTE;
+                    position++;
+                    checksum += position * (static_cast<uint64_t>(packet.getId()) * 31 + member);
+                }
+            }
+        }
+        return Clock::now() - start;
+    }
+}
+
+void Benchmark::runAll() {
+    runClassifier();
+    runEventQueue();
+    runForwarding();
+    runRouteUpdates();
+    runParser();
+    runTopology();
+}
+
+void Benchmark::runClassifier() {
+    cout << "\n--- Classifier Benchmark ---" << endl;
+    cout << "Clock source: " << Clock::getSource() << endl;
+    runClassifier(100, 1000000);
+    runClassifier(1000, 1000000);
+    runClassifier(10000, 1000000);
+}
+
+// Half of the packets are drawn from a rule so they hit specific rules;
+// the rest are random and mostly fall through to the final catch-all.
+void Benchmark::runClassifier(size_t ruleCount, size_t packetCount) {
+    mt19937 rng(static_cast<unsigned>(ruleCount));
+    PacketClassifier classifier;
+    vector<ClassifierRule> rules;
+
+    for (size_t i = 0; i + 1 < ruleCount; i++) {
+        rules.push_back(randomRule(rng));
+        classifier.addRule(rules.back());
+    }
+    ClassifierRule catchAll = { 0, 0, 0, 0, 0, 65535, 2 };
+    classifier.addRule(catchAll);
+
+    long long buildStart = Clock::now();
+    classifier.build();
+    long long buildTime = Clock::now() - buildStart;
+
+    vector<uint32_t> sources(packetCount);
+    vector<uint32_t> destinations(packetCount);
+    vector<int> ports(packetCount);
+    for (size_t i = 0; i < packetCount; i++) {
+        sources[i] = static_cast<uint32_t>(rng());
+        destinations[i] = static_cast<uint32_t>(rng());
+        ports[i] = static_cast<int>(rng() % 65536);
+        if (i % 2 == 0) {
+            const ClassifierRule& rule = rules[rng() % rules.size()];
+            uint32_t sourceMask = IPAddress::prefixMask(rule.sourceLength);
+            uint32_t destinationMask = IPAddress::prefixMask(rule.destinationLength);
+            sources[i] = (rule.source & sourceMask) | (sources[i] & ~sourceMask);
+            destinations[i] = (rule.destination & destinationMask) | (destinations[i] & ~destinationMask);
+            ports[i] = rule.portLow + static_cast<int>(rng() % (rule.portHigh - rule.portLow + 1));
+        }
+    }
+
+    vector<int> classes(packetCount);
+    long long tupleStart = Clock::now();
+    for (size_t i = 0; i < packetCount; i++) {
+        classes[i] = classifier.classify(sources[i], destinations[i], ports[i]);
+    }
+    long long tupleTime = Clock::now() - tupleStart;
+
+    // The linear scan is slow at 10k rules, so it runs on a sample
+    size_t linearCount = packetCount / 10;
+    vector<int> expected(linearCount);
+    long long linearStart = Clock::now();
+    for (size_t i = 0; i < linearCount; i++) {
+        expected[i] = classifier.classifyLinear(sources[i], destinations[i], ports[i]);
+    }
+    long long linearTime = Clock::now() - linearStart;
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < linearCount; i++) {
+        if (expected[i] != classes[i]) {
+            mismatches++;
+        }
+    }
+
+    cout << ruleCount << " rules: " << classifier.getTupleCount() << " tuples, "
+        << classifier.getEntryCount() << " entries, build " << Clock::toMilliseconds(buildTime) << "ms" << endl;
+    cout << "  tuple space: " << static_cast<double>(tupleTime) / packetCount << " ns/packet"
+        << "  linear scan: " << static_cast<double>(linearTime) / linearCount << " ns/packet"
+        << "  mismatches: " << mismatches << endl;
+}
+
+void Benchmark::runEventQueue() {
+    cout << "\n--- Event Queue Benchmark ---" << endl;
+    runEventQueue(1000, 10000000);
+    runEventQueue(100000, 10000000);
+    runEventQueue(1000000, 10000000);
+}
+
+// Hold model: with a fixed number of pending events, repeatedly pop the
+// earliest one and schedule a successor a random (exponential) time later,
+// as a simulation does. std::priority_queue is the reference.
+void Benchmark::runEventQueue(size_t pendingEvents, size_t operations) {
+    struct Later {
+        bool operator()(const SimEvent& a, const SimEvent& b) const {
+            return a.time > b.time;
+        }
+    };
+
+    mt19937_64 rng(static_cast<unsigned long long>(pendingEvents));
+    exponential_distribution<double> gap(1.0 / 1000000.0);
+    vector<long long> delays(operations);
+    for (size_t i = 0; i < operations; i++) {
+        delays[i] = 1 + static_cast<long long>(gap(rng));
+    }
+
+    EventQueue radixHeap;
+    priority_queue<SimEvent, vector<SimEvent>, Later> binaryHeap;
+    for (size_t i = 0; i < pendingEvents; i++) {
+        SimEvent event = { delays[i % operations], 0, static_cast<uint32_t>(i) };
+        radixHeap.push(event);
+        binaryHeap.push(event);
+    }
+
+    long long radixSum = 0;
+    long long radixStart = Clock::now();
+    for (size_t i = 0; i < operations; i++) {
+        SimEvent event = radixHeap.pop();
+        radixSum += event.time;
+        event.time += delays[i];
+        radixHeap.push(event);
+    }
+    long long radixTime = Clock::now() - radixStart;
+
+    long long binarySum = 0;
+    long long binaryStart = Clock::now();
+    for (size_t i = 0; i < operations; i++) {
+        SimEvent event = binaryHeap.top();
+        binaryHeap.pop();
+        binarySum += event.time;
+        event.time += delays[i];
+        binaryHeap.push(event);
+    }
+    long long binaryTime = Clock::now() - binaryStart;
+
+    cout << pendingEvents << " pending: radix heap " << static_cast<double>(radixTime) / operations
+        << " ns/event, binary heap " << static_cast<double>(binaryTime) / operations << " ns/event"
+        << (radixSum == binarySum ? "" : "  (ORDER MISMATCH)") << endl;
+}
+
+void Benchmark::runTopology() {
+    cout << "\n--- Topology Simulation Benchmark ---" << endl;
+    int threads = static_cast<int>(thread::hardware_concurrency());
+    if (threads < 2) {
+        threads = 2;
+    }
+    runTopology(1000, threads);
+    runTopology(10000, threads);
+}
+
+// A 4-ary tree of routers on 1 Gbit/s, 100us links, each router sending
+// Poisson traffic to a random other router, 100k packets/s in total (about
+// 60% load on the root's links), for 500ms of virtual time. The
+// single-threaded run is the reference for the partitioned one.
+void Benchmark::runTopology(size_t routerCount, int threadCount) {
+    long long duration = 500000000LL;
+    double rate = 100000.0 / routerCount;
+    long long delivered[2] = { 0, 0 };
+    long long wallTime[2] = { 0, 0 };
+    long long events = 0;
+    long long steadyAllocations = 0;
+    int threadCounts[2] = { 1, threadCount };
+
+    for (int run = 0; run < 2; run++) {
+        Topology topology;
+        topology.generateTree(routerCount, 4, 1e9, 100000);
+        mt19937 rng(static_cast<unsigned>(routerCount));
+        for (uint32_t router = 0; router < routerCount; router++) {
+            uint32_t target = static_cast<uint32_t>(rng() % routerCount);
+            string source = IPAddress::toString(topology.getRouter(router).prefix | 1);
+            string destination = IPAddress::toString(topology.getRouter(target).prefix | 10);
+            int port = static_cast<int>(rng() % 65536);
+            topology.addSource(router, TrafficSource(source, destination, port, 1000,
+                TrafficSource::POISSON, rate, router));
+        }
+        topology.build(nullptr);
+
+        NetworkSimulator simulator(&topology, threadCounts[run]);
+        simulator.run(duration);
+        delivered[run] = simulator.getDeliveredCount();
+        wallTime[run] = simulator.getWallTime();
+        events = simulator.getEventCount();
+        steadyAllocations += simulator.getSteadyStateAllocations();
+    }
+
+    cout << routerCount << " routers: " << events << " events, " << delivered[0] << " delivered | 1 thread "
+        << Clock::toMilliseconds(wallTime[0]) << "ms, " << threadCount << " threads "
+        << Clock::toMilliseconds(wallTime[1]) << "ms | " << steadyAllocations << " heap allocations after warm-up"
+        << (delivered[0] == delivered[1] ? "" : "  (RESULT MISMATCH)") << endl;
+}
+
+void Benchmark::runForwarding() {
+    cout << "\n--- Forwarding Path Benchmark ---" << endl;
+    runForwarding(1000, 1000000);
+    runForwarding(100000, 1000000);
+}
+
+// A FIB of 10k routes (some ECMP) and traffic from flowCount flows with
+// ports spread over all three classes, pushed in bursts of 32 through the
+// runtime QoService path and through compiled DefaultForwardingPath-style
+// instantiations. Without QoS rules all of them make the same decisions.
+void Benchmark::runForwarding(size_t flowCount, size_t packetCount) {
+    const size_t ROUTE_COUNT = 10000;
+    const size_t BURST = 32;
+    const size_t INPUT_SIZE = 65536;
+    const int QUEUE_SIZE = 256;
+
+    mt19937 rng(static_cast<unsigned>(flowCount));
+    RoutingTable rib;
+    rib.addRoute("0.0.0.0", 0, "Default", 1);
+    vector<uint32_t> prefixes;
+    for (size_t i = 0; i < ROUTE_COUNT; i++) {
+        int length = 16 + static_cast<int>(rng() % 9);
+        uint32_t prefix = static_cast<uint32_t>(rng()) & IPAddress::prefixMask(length);
+        prefixes.push_back(prefix);
+        rib.addRoute(IPAddress::toString(prefix), length, "Hop" + to_string(rng() % 64), 1);
+        if (i % 8 == 0) {
+            rib.addRoute(IPAddress::toString(prefix), length, "Hop" + to_string(rng() % 64), 1);
+        }
+    }
+    ForwardingTable fib;
+    fib.build(rib);
+
+    vector<packets> flows;
+    for (size_t i = 0; i < flowCount; i++) {
+        uint32_t destination = prefixes[rng() % prefixes.size()] | (rng() & 0xFF);
+        flows.push_back(packets(0, IPAddress::toString(static_cast<uint32_t>(rng())),
+            IPAddress::toString(destination), static_cast<int>(rng() % 65536), 2 + static_cast<int>(rng() % 63)));
+    }
+    vector<packets> input;
+    for (size_t i = 0; i < INPUT_SIZE; i++) {
+        const packets& flow = flows[rng() % flows.size()];
+        input.push_back(packets(static_cast<int>(i + 1), flow.getSource(), flow.getDestination(),
+            flow.getPort(), flow.getTTL()));
+    }
+    size_t rounds = (packetCount + INPUT_SIZE - 1) / INPUT_SIZE;
+    double forwarded = static_cast<double>(rounds * INPUT_SIZE);
+
+    uint64_t runtimeSum = 0;
+    FlowTable runtimeFlows;
+    QoService qos(QUEUE_SIZE);
+    qos.setFlowTable(&runtimeFlows);
+    RuntimeForwardingPath runtimePath(&qos, FlowCachedFib(&runtimeFlows, &fib));
+    long long runtimeTime = forwardBursts(runtimePath, input, BURST, rounds, runtimeSum);
+
+    uint64_t cachedSum = 0;
+    FlowTable compiledFlows;
+    DefaultForwardingPath cachedPath(FlowCachedFib(&compiledFlows, &fib), QUEUE_SIZE);
+    long long cachedTime = forwardBursts(cachedPath, input, BURST, rounds, cachedSum);
+
+    uint64_t lookupSum = 0;
+    ForwardingPath<PortRangePolicy, StrictPriorityScheduler, CompiledFib> lookupPath(CompiledFib(&fib), QUEUE_SIZE);
+    long long lookupTime = forwardBursts(lookupPath, input, BURST, rounds, lookupSum);
+
+    cout << flowCount << " flows: runtime " << runtimeTime / forwarded << " ns/packet"
+        << "  compiled " << cachedTime / forwarded << " ns/packet ("
+        << static_cast<double>(runtimeTime) / cachedTime << "x)"
+        << "  compiled, no flow cache " << lookupTime / forwarded << " ns/packet"
+        << (runtimeSum == cachedSum && runtimeSum == lookupSum ? "" : "  (RESULT MISMATCH)") << endl;
+}
+
+void Benchmark::runParser() {
+    cout << "\n--- Packet Parser Benchmark ---" << endl;
+    runParser(1000000);
+}
+
+// Parses an in-memory packet file, so storage is out of the picture, with
+// 1, 2, 4, ... threads up to the core count. Every run must produce the
+// single-threaded result in the same order.
+void Benchmark::runParser(size_t packetCount) {
+    mt19937 rng(static_cast<unsigned>(packetCount));
+    string text = "ID,Source,Destination,Port,TTL\n";
+    for (size_t i = 0; i < packetCount; i++) {
+        text += to_string(i + 1) + "," + IPAddress::toString(static_cast<uint32_t>(rng())) + ","
+            + IPAddress::toString(static_cast<uint32_t>(rng())) + "," + to_string(rng() % 65536) + ","
+            + to_string(1 + rng() % 64) + "\n";
+    }
+    double megabytes = text.size() / 1e6;
+
+    int maxThreads = static_cast<int>(thread::hardware_concurrency());
+    if (maxThreads < 1) {
+        maxThreads = 1;
+    }
+
+    vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    vector<packets> reference;
+    for (int threads : threadCounts) {
+        PacketParser parser(threads);
+        vector<packets> packetList;
+        parser.parse(text.data(), text.size(), packetList);
+
+        bool match = packetList.size() == packetCount;
+        if (threads == 1) {
+            reference.swap(packetList);
+        }
+        else {
+            for (size_t i = 0; match && i < packetList.size(); i++) {
+                match = packetList[i].getId() == reference[i].getId() &&
+                    packetList[i].getDestinationAddress() == reference[i].getDestinationAddress() &&
+                    packetList[i].getTTL() == reference[i].getTTL();
+            }
+        }
+
+        double seconds = parser.getParseTime() / 1e9;
+        cout << packetCount << " packets (" << megabytes << "MB), " << threads << " threads: "
+            << Clock::toMilliseconds(parser.getParseTime()) << "ms, " << megabytes / seconds << " MB/s, "
+            << packetCount / seconds / 1e6 << "M packets/s" << (match ? "" : "  (RESULT MISMATCH)") << endl;
+    }
+}
+
+void Benchmark::runRouteUpdates() {
+    cout << "\n--- Route Update Benchmark ---" << endl;
+    runRouteUpdates(10000, 100000);
+    runRouteUpdates(500000, 100000);
+}
+
+// Replays a burst of announces and withdraws against a large FIB in
+// batches of RouterDriver::UPDATE_BATCH_SIZE, as the driver does, and times
+// every batch: lookups wait for the batch, so the longest one is the worst
+// lookup stall. The same updates go to a RIB; a FIB rebuilt from it must
+// forward every updated prefix boundary and random addresses the same way.
+void Benchmark::runRouteUpdates(size_t routeCount, size_t updateCount) {
+    const size_t BATCH_SIZE = 1024;
+    const size_t PROBE_COUNT = 100000;
+
+    mt19937 rng(static_cast<unsigned>(routeCount));
+    RoutingTable rib;
+    rib.addRoute("0.0.0.0", 0, "Default", 1);
+    vector<pair<uint32_t, int>> prefixes;
+    for (size_t i = 0; i < routeCount; i++) {
+        int length = 16 + static_cast<int>(rng() % 9);
+        uint32_t prefix = static_cast<uint32_t>(rng()) & IPAddress::prefixMask(length);
+        prefixes.push_back(make_pair(prefix, length));
+        rib.addRoute(IPAddress::toString(prefix), length, "Hop" + to_string(rng() % 64), 1);
+    }
+    ForwardingTable fib;
+    fib.build(rib);
+
+    // Half withdraw a known prefix, half announce one: a known prefix with a
+    // new next hop and maybe metric, or a new prefix next to a known one
+    vector<RouteUpdate> updates;
+    for (size_t i = 0; i < updateCount; i++) {
+        RouteUpdate update;
+        const pair<uint32_t, int>& known = prefixes[rng() % prefixes.size()];
+        update.announce = rng() % 2 == 0;
+        update.prefix = known.first;
+        update.prefixLength = known.second;
+        update.metric = 1;
+        if (update.announce) {
+            if (rng() % 2 == 0) {
+                update.prefixLength = 16 + static_cast<int>(rng() % 9);
+                update.prefix = (known.first ^ (static_cast<uint32_t>(rng()) & 0xFFFF))
+                    & IPAddress::prefixMask(update.prefixLength);
+                prefixes.push_back(make_pair(update.prefix, update.prefixLength));
+            }
+            update.metric = 1 + static_cast<int>(rng() % 2);
+            update.nextHops.push_back("Hop" + to_string(rng() % 64));
+            if (rng() % 8 == 0) {
+                update.nextHops.push_back("Hop" + to_string(rng() % 64));
+            }
+        }
+        updates.push_back(update);
+    }
+
+    long long totalTime = 0;
+    long long worstStall = 0;
+    size_t batches = 0;
+    vector<RouteUpdate> batch;
+    for (size_t first = 0; first < updates.size(); first += BATCH_SIZE) {
+        size_t last = min(first + BATCH_SIZE, updates.size());
+        batch.assign(updates.begin() + first, updates.begin() + last);
+        long long start = Clock::now();
+        fib.applyUpdates(batch);
+        long long elapsed = Clock::now() - start;
+        totalTime += elapsed;
+        worstStall = max(worstStall, elapsed);
+        batches++;
+    }
+
+    for (const auto& update : updates) {
+        string prefix = IPAddress::toString(update.prefix);
+        if (!update.announce) {
+            rib.removeRoute(prefix, update.prefixLength);
+            continue;
+        }
+        for (const auto& nextHop : update.nextHops) {
+            rib.addRoute(prefix, update.prefixLength, nextHop, update.metric);
+        }
+    }
+    ForwardingTable rebuilt;
+    rebuilt.build(rib);
+
+    vector<uint32_t> probes;
+    for (const auto& update : updates) {
+        uint32_t end = update.prefix | ~IPAddress::prefixMask(update.prefixLength);
+        probes.push_back(update.prefix);
+        probes.push_back(update.prefix - 1);
+        probes.push_back(end);
+        probes.push_back(end + 1);
+    }
+    for (size_t i = 0; i < PROBE_COUNT; i++) {
+        probes.push_back(static_cast<uint32_t>(rng()));
+    }
+    size_t mismatches = 0;
+    for (uint32_t address : probes) {
+        if (forwardedHop(fib, address) != forwardedHop(rebuilt, address)) {
+            mismatches++;
+        }
+    }
+
+    cout << routeCount << " routes (" << fib.getRangeCount() << " ranges), " << updateCount << " updates in "
+        << batches << " batches: " << static_cast<long long>(updateCount * 1e9 / totalTime) << " updates/s"
+        << "  worst stall " << Clock::toMilliseconds(worstStall) << "ms"
+        << "  mean " << Clock::toMilliseconds(totalTime / static_cast<long long>(batches)) << "ms"
+        << (mismatches == 0 ? "" : "  (RESULT MISMATCH)") << endl;
+}
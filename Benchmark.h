@@ -0,0 +1,27 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstddef>
+
+// Synthetic micro-benchmarks, run with "router --bench". Each benchmark
+// checks its fast path against a reference implementation while timing it.
+class Benchmark {
+public:
+    static void runAll();
+    static void runClassifier();
+    static void runEventQueue();
+    static void runTopology();
+    static void runForwarding();
+    static void runParser();
+    static void runRouteUpdates();
+
+private:
+    static void runClassifier(size_t ruleCount, size_t packetCount);
+    static void runEventQueue(size_t pendingEvents, size_t operations);
+    static void runTopology(size_t routerCount, int threadCount);
+    static void runForwarding(size_t flowCount, size_t packetCount);
+    static void runParser(size_t packetCount);
+    static void runRouteUpdates(size_t routeCount, size_t updateCount);
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "Clock.h"
+#include <chrono>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CLOCK_HAS_TSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define CLOCK_HAS_TSC 1
+#else
+#define CLOCK_HAS_TSC 0
+#endif
+
+using namespace std;
+
+long long Clock::now() {
+    const Calibration& cal = calibration();
+
+    if (cal.useTSC) {
+        // Signed: another core's TSC may read slightly behind baseTicks,
+        // which must not wrap to a huge unsigned delta
+        long long ticks = static_cast<long long>(readTSC() - cal.baseTicks);
+        if (ticks < 0) {
+            ticks = 0;
+        }
+        return cal.baseNanos + static_cast<long long>(ticks * cal.nanosPerTick);
+    }
+    return steadyNanos();
+}
+
+string Clock::getSource() {
+    return calibration().useTSC ? "TSC" : "steady_clock";
+}
+
+double Clock::getTicksPerNanosecond() {
+    const Calibration& cal = calibration();
+    return cal.useTSC ? 1.0 / cal.nanosPerTick : 1.0;
+}
+
+double Clock::toMilliseconds(long long nanos) {
+    return nanos / 1000000.0;
+}
+
+const Clock::Calibration& Clock::calibration() {
+    static const Calibration cal = calibrate();
+    return cal;
+}
+
+// Samples the TSC and steady_clock across a short sleep to derive the tick
+// period. Done once per process; now() afterwards is a single rdtsc.
+Clock::Calibration Clock::calibrate() {
+    Calibration cal;
+    cal.useTSC = false;
+    cal.baseTicks = 0;
+    cal.baseNanos = steadyNanos();
+    cal.nanosPerTick = 1.0;
+
+    if (!hasInvariantTSC()) {
+        return cal;
+    }
+
+    long long startNanos = steadyNanos();
+    unsigned long long startTicks = readTSC();
+    this_thread::sleep_for(chrono::milliseconds(20));
+    long long endNanos = steadyNanos();
+    unsigned long long endTicks = readTSC();
+
+    if (endTicks <= startTicks || endNanos <= startNanos) {
+        return cal;
+    }
+
+    cal.useTSC = true;
+    cal.baseTicks = endTicks;
+    cal.baseNanos = endNanos;
+    cal.nanosPerTick = static_cast<double>(endNanos - startNanos) / (endTicks - startTicks);
+    return cal;
+}
+
+// CPUID leaf 0x80000007, EDX bit 8: TSC runs at a constant rate across
+// P-/C-states, so it can be used as a wall-rate clock.
+bool Clock::hasInvariantTSC() {
+#if CLOCK_HAS_TSC && defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0x80000000);
+    if (static_cast<unsigned int>(regs[0]) < 0x80000007u) {
+        return false;
+    }
+    __cpuid(regs, 0x80000007);
+    return (regs[3] & (1 << 8)) != 0;
+#elif CLOCK_HAS_TSC
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007u) {
+        return false;
+    }
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+unsigned long long Clock::readTSC() {
+#if CLOCK_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+long long Clock::steadyNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
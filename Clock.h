@@ -0,0 +1,32 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <string>
+
+// Monotonic nanosecond clock used for trace stamps and queue sojourn times.
+// Reads the invariant TSC when the CPU has one (calibrated once against
+// steady_clock), otherwise falls back to std::chrono::steady_clock.
+class Clock {
+public:
+    static long long now();
+    static std::string getSource();
+    static double getTicksPerNanosecond();
+
+    static double toMilliseconds(long long nanos);
+
+private:
+    struct Calibration {
+        bool useTSC;
+        unsigned long long baseTicks;
+        long long baseNanos;
+        double nanosPerTick;
+    };
+
+    static const Calibration& calibration();
+    static Calibration calibrate();
+    static bool hasInvariantTSC();
+    static unsigned long long readTSC();
+    static long long steadyNanos();
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "EventQueue.h"
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+    int highestBit(uint64_t value) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<int>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(value);
+#else
+        int index = 0;
+        while (value >>= 1) {
+            index++;
+        }
+        return index;
+#endif
+    }
+
+    int lowestBit(uint64_t value) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<int>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(value);
+#else
+        int index = 0;
+        while ((value & 1) == 0) {
+            value >>= 1;
+            index++;
+        }
+        return index;
+#endif
+    }
+}
+
+EventQueue::EventQueue() : occupied(0), last(0), count(0) {
+}
+
+int EventQueue::bucketFor(uint64_t time) const {
+    uint64_t diff = time ^ last;
+    return diff == 0 ? 0 : highestBit(diff) + 1;
+}
+
+// Events in the past are treated as due now.
+// Time Complexity: O(1)
+void EventQueue::push(const SimEvent& event) {
+    SimEvent queued = event;
+    if (queued.time < static_cast<long long>(last)) {
+        queued.time = static_cast<long long>(last);
+    }
+
+    int bucket = bucketFor(static_cast<uint64_t>(queued.time));
+    buckets[bucket].push_back(queued);
+    if (bucket > 0) {
+        occupied |= 1ull << (bucket - 1);
+    }
+    count++;
+}
+
+// Refills bucket 0 from the lowest non-empty bucket: its minimum becomes
+// the new reference time and the rest move to lower buckets.
+void EventQueue::refill() {
+    int bucket = lowestBit(occupied) + 1;
+    vector<SimEvent>& source = buckets[bucket];
+
+    uint64_t minTime = static_cast<uint64_t>(source[0].time);
+    for (size_t i = 1; i < source.size(); i++) {
+        if (static_cast<uint64_t>(source[i].time) < minTime) {
+            minTime = static_cast<uint64_t>(source[i].time);
+        }
+    }
+    last = minTime;
+
+    for (size_t i = 0; i < source.size(); i++) {
+        int target = bucketFor(static_cast<uint64_t>(source[i].time));
+        buckets[target].push_back(source[i]);
+        if (target > 0) {
+            occupied |= 1ull << (target - 1);
+        }
+    }
+    source.clear();
+    occupied &= ~(1ull << (bucket - 1));
+}
+
+// Removes and returns the earliest event; the queue must not be empty.
+// Time Complexity: O(1) amortized per bit of the event time
+SimEvent EventQueue::pop() {
+    if (buckets[0].empty()) {
+        refill();
+    }
+
+    SimEvent event = buckets[0].back();
+    buckets[0].pop_back();
+    count--;
+    return event;
+}
+
+// Time of the earliest event without removing it; the queue must not be
+// empty. Unlike pop() this does not advance the reference time, so events
+// earlier than the peeked one may still be pushed.
+long long EventQueue::peekTime() const {
+    if (!buckets[0].empty()) {
+        return static_cast<long long>(last);
+    }
+
+    const vector<SimEvent>& source = buckets[lowestBit(occupied) + 1];
+    long long minTime = source[0].time;
+    for (size_t i = 1; i < source.size(); i++) {
+        if (source[i].time < minTime) {
+            minTime = source[i].time;
+        }
+    }
+    return minTime;
+}
+
+bool EventQueue::empty() const {
+    return count == 0;
+}
+
+size_t EventQueue::size() const {
+    return count;
+}
+
+long long EventQueue::getLastTime() const {
+    return static_cast<long long>(last);
+}
+
+void EventQueue::clear() {
+    for (int bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+        buckets[bucket].clear();
+    }
+    occupied = 0;
+    last = 0;
+    count = 0;
+}
@@ -0,0 +1,47 @@
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct SimEvent {
+    long long time;
+    uint32_t type;
+    uint32_t target;
+};
+
+// Monotone priority queue of simulation events (radix heap).
+//
+// Events may only be scheduled at or after the time of the last popped
+// event, which always holds for a discrete-event simulation. Bucket i holds
+// events whose time first differs from the last popped time in bit i - 1,
+// so push is O(1) and every event is moved at most 64 times over its
+// lifetime, instead of the O(log n) sift of a binary heap. Events with equal
+// times are popped in no particular order.
+class EventQueue {
+public:
+    EventQueue();
+
+    void push(const SimEvent& event);
+    SimEvent pop();
+    long long peekTime() const;
+
+    bool empty() const;
+    size_t size() const;
+    long long getLastTime() const;
+    void clear();
+
+private:
+    static const int BUCKET_COUNT = 65;
+
+    std::vector<SimEvent> buckets[BUCKET_COUNT];
+    uint64_t occupied;
+    uint64_t last;
+    size_t count;
+
+    int bucketFor(uint64_t time) const;
+    void refill();
+};
+
+#endif
@@ -0,0 +1,240 @@
+#include "FlowTable.h"
+#include "IPAddress.h"
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+using namespace std;
+
+FlowTable::FlowTable(size_t capacity, long long idleTimeout)
+    : idleTimeout(idleTimeout), routeEpoch(1), routeVersion(0), flowCount(0),
+    hits(0), misses(0), evictions(0), expirations(0) {
+    uint32_t bits = 0;
+    while ((static_cast<size_t>(1) << bits) * WAYS < capacity && bits < 31) {
+        bits++;
+    }
+    bucketShift = 32 - bits;
+
+    FlowBucket empty;
+    for (uint32_t way = 0; way < WAYS; way++) {
+        empty.entries[way].source = 0;
+        empty.entries[way].destination = 0;
+        empty.entries[way].port = 0;
+        empty.entries[way].qosClass = EMPTY_CLASS;
+        empty.entries[way].routeEpoch = NO_EPOCH;
+        empty.entries[way].member = 0;
+    }
+    buckets.assign(static_cast<size_t>(1) << bits, empty);
+
+    FlowStats noStats;
+    noStats.packets = 0;
+    noStats.lastSeen = 0;
+    stats.assign(buckets.size() * WAYS, noStats);
+}
+
+// Hashes the flow identity (splitmix64 finalizer); the top bits pick the
+// bucket here and the low bits pick the ECMP member in the ForwardingTable.
+uint32_t FlowTable::flowHash(uint32_t source, uint32_t destination, uint16_t port) {
+    uint64_t key = (static_cast<uint64_t>(source) << 32) | destination;
+    key ^= static_cast<uint64_t>(port) * 0x9E3779B97F4A7C15ull;
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBull;
+    key ^= key >> 31;
+    return static_cast<uint32_t>(key >> 32);
+}
+
+const FlowTable::FlowEntry& FlowTable::entryAt(uint32_t slot) const {
+    return buckets[slot / WAYS].entries[slot % WAYS];
+}
+
+FlowTable::FlowEntry& FlowTable::entryAt(uint32_t slot) {
+    return buckets[slot / WAYS].entries[slot % WAYS];
+}
+
+// Returns the flow's slot, inserting it on a miss. A hit only reads the
+// flow's bucket; a miss reuses a free or idle way before evicting the least
+// recently seen flow of the bucket. Time Complexity: O(1)
+uint32_t FlowTable::acquire(uint32_t source, uint32_t destination, uint16_t port, uint32_t flowHash, long long now) {
+    uint32_t bucketIndex = static_cast<uint32_t>(static_cast<uint64_t>(flowHash) >> bucketShift);
+    FlowBucket& bucket = buckets[bucketIndex];
+    uint32_t base = bucketIndex * WAYS;
+    uint32_t freeWay = WAYS;
+
+    for (uint32_t way = 0; way < WAYS; way++) {
+        const FlowEntry& entry = bucket.entries[way];
+        if (entry.qosClass == EMPTY_CLASS) {
+            if (freeWay == WAYS) {
+                freeWay = way;
+            }
+        }
+        else if (entry.source == source && entry.destination == destination && entry.port == port) {
+            hits++;
+            return base + way;
+        }
+    }
+    misses++;
+
+    if (freeWay == WAYS) {
+        uint32_t oldestWay = 0;
+        for (uint32_t way = 1; way < WAYS; way++) {
+            if (stats[base + way].lastSeen < stats[base + oldestWay].lastSeen) {
+                oldestWay = way;
+            }
+        }
+        freeWay = oldestWay;
+
+        if (now - stats[base + oldestWay].lastSeen > idleTimeout) {
+            expirations++;
+        }
+        else {
+            evictions++;
+        }
+        flowCount--;
+    }
+
+    FlowEntry& entry = bucket.entries[freeWay];
+    entry.source = source;
+    entry.destination = destination;
+    entry.port = port;
+    entry.qosClass = UNCLASSIFIED_CLASS;
+    entry.routeEpoch = NO_EPOCH;
+    entry.member = 0;
+    stats[base + freeWay].packets = 0;
+    stats[base + freeWay].lastSeen = now;
+    flowCount++;
+    return base + freeWay;
+}
+
+bool FlowTable::matches(uint32_t slot, uint32_t source, uint32_t destination, uint16_t port) const {
+    const FlowEntry& entry = entryAt(slot);
+    return entry.qosClass != EMPTY_CLASS && entry.source == source &&
+        entry.destination == destination && entry.port == port;
+}
+
+void FlowTable::recordPacket(uint32_t slot, long long now) {
+    stats[slot].packets++;
+    stats[slot].lastSeen = now;
+}
+
+// Packets counted against the flow since it was inserted
+uint64_t FlowTable::getPacketCount(uint32_t slot) const {
+    return stats[slot].packets;
+}
+
+int FlowTable::getQosClass(uint32_t slot) const {
+    uint8_t qosClass = entryAt(slot).qosClass;
+    return qosClass == UNCLASSIFIED_CLASS ? UNCLASSIFIED : qosClass;
+}
+
+void FlowTable::setQosClass(uint32_t slot, int qosClass) {
+    entryAt(slot).qosClass = static_cast<uint8_t>(qosClass);
+}
+
+bool FlowTable::getCachedMember(uint32_t slot, uint32_t& member) const {
+    const FlowEntry& entry = entryAt(slot);
+    if (entry.routeEpoch != routeEpoch) {
+        return false;
+    }
+    member = entry.member;
+    return true;
+}
+
+void FlowTable::setCachedMember(uint32_t slot, uint32_t member) {
+    FlowEntry& entry = entryAt(slot);
+    entry.member = member;
+    entry.routeEpoch = routeEpoch;
+}
+
+// Called when the FIB changes. Cached decisions are tagged with an 8-bit
+// epoch, so invalidation is O(1) except when the epoch wraps and every
+// entry has to be cleared.
+void FlowTable::invalidateRoutes(uint64_t version) {
+    routeVersion = version;
+    routeEpoch++;
+    if (routeEpoch != NO_EPOCH) {
+        return;
+    }
+
+    routeEpoch = 1;
+    for (auto& bucket : buckets) {
+        for (uint32_t way = 0; way < WAYS; way++) {
+            bucket.entries[way].routeEpoch = NO_EPOCH;
+        }
+    }
+}
+
+uint64_t FlowTable::getRouteVersion() const {
+    return routeVersion;
+}
+
+// Removes every flow idle for longer than idleTimeout.
+// Time Complexity: O(capacity)
+size_t FlowTable::expire(long long now) {
+    size_t expired = 0;
+    for (uint32_t slot = 0; slot < stats.size(); slot++) {
+        FlowEntry& entry = entryAt(slot);
+        if (entry.qosClass != EMPTY_CLASS && now - stats[slot].lastSeen > idleTimeout) {
+            entry.qosClass = EMPTY_CLASS;
+            entry.routeEpoch = NO_EPOCH;
+            expired++;
+        }
+    }
+    flowCount -= expired;
+    expirations += expired;
+    return expired;
+}
+
+size_t FlowTable::getFlowCount() const {
+    return flowCount;
+}
+
+size_t FlowTable::getCapacity() const {
+    return stats.size();
+}
+
+double FlowTable::getOccupancy() const {
+    return static_cast<double>(flowCount) / stats.size();
+}
+
+uint64_t FlowTable::getHits() const {
+    return hits;
+}
+
+uint64_t FlowTable::getMisses() const {
+    return misses;
+}
+
+uint64_t FlowTable::getEvictions() const {
+    return evictions;
+}
+
+uint64_t FlowTable::getExpirations() const {
+    return expirations;
+}
+
+// Counters, then the busiest flows. Time Complexity: O(capacity)
+void FlowTable::displayStats() const {
+    cout << "Flow Table: " << flowCount << "/" << getCapacity() << " flows ("
+        << getOccupancy() * 100 << "% occupied)"
+        << " Hits:" << hits << " Misses:" << misses
+        << " Evictions:" << evictions << " Expirations:" << expirations << endl;
+
+    vector<pair<uint64_t, uint32_t>> busiest;
+    for (uint32_t slot = 0; slot < stats.size(); slot++) {
+        if (entryAt(slot).qosClass != EMPTY_CLASS && stats[slot].packets > 0) {
+            busiest.push_back(make_pair(stats[slot].packets, slot));
+        }
+    }
+    size_t shown = min(busiest.size(), TOP_FLOWS);
+    partial_sort(busiest.begin(), busiest.begin() + shown, busiest.end(),
+        [](const pair<uint64_t, uint32_t>& a, const pair<uint64_t, uint32_t>& b) { return a.first > b.first; });
+
+    for (size_t i = 0; i < shown; i++) {
+        const FlowEntry& entry = entryAt(busiest[i].second);
+        cout << "  Top flow: " << IPAddress::toString(entry.source) << " -> "
+            << IPAddress::toString(entry.destination) << ":" << entry.port << " "
+            << getPacketCount(busiest[i].second) << " packets" << endl;
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef FLOWTABLE_H
+#define FLOWTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing flow cache keyed by (source, destination, port).
+//
+// The table is 4-way set associative: a flow hashes to one 64-byte bucket
+// holding four 16-byte entries, so a lookup is a single cache-line probe.
+// Entries cache the flow's QoS class and its forwarding decision (the ECMP
+// member chosen by the ForwardingTable); per-flow counters and the last-seen
+// time live in a parallel array. Idle flows age out after idleTimeout and a
+// full bucket evicts its least recently seen flow.
+//
+// Ports are 16 bits, as on the wire: callers narrow a packet's port once and
+// the same value is hashed, stored and compared.
+class FlowTable {
+public:
+    static const uint32_t NO_SLOT = 0xFFFFFFFFu;
+    static const int UNCLASSIFIED = -1;
+
+    FlowTable(size_t capacity = 65536, long long idleTimeout = 30000000000LL);
+
+    static uint32_t flowHash(uint32_t source, uint32_t destination, uint16_t port);
+
+    uint32_t acquire(uint32_t source, uint32_t destination, uint16_t port, uint32_t flowHash, long long now);
+    bool matches(uint32_t slot, uint32_t source, uint32_t destination, uint16_t port) const;
+    void recordPacket(uint32_t slot, long long now);
+    uint64_t getPacketCount(uint32_t slot) const;
+
+    int getQosClass(uint32_t slot) const;
+    void setQosClass(uint32_t slot, int qosClass);
+
+    bool getCachedMember(uint32_t slot, uint32_t& member) const;
+    void setCachedMember(uint32_t slot, uint32_t member);
+    void invalidateRoutes(uint64_t routeVersion);
+    uint64_t getRouteVersion() const;
+
+    size_t expire(long long now);
+
+    size_t getFlowCount() const;
+    size_t getCapacity() const;
+    double getOccupancy() const;
+    uint64_t getHits() const;
+    uint64_t getMisses() const;
+    uint64_t getEvictions() const;
+    uint64_t getExpirations() const;
+    void displayStats() const;
+
+private:
+    static const uint32_t WAYS = 4;
+    static const uint8_t EMPTY_CLASS = 0xFF;
+    static const uint8_t UNCLASSIFIED_CLASS = 0xFE;
+    static const uint8_t NO_EPOCH = 0;
+    static constexpr size_t TOP_FLOWS = 3;
+
+    struct FlowEntry {
+        uint32_t source;
+        uint32_t destination;
+        uint16_t port;
+        uint8_t qosClass;
+        uint8_t routeEpoch;
+        uint32_t member;
+    };
+
+    struct alignas(64) FlowBucket {
+        FlowEntry entries[WAYS];
+    };
+
+    struct FlowStats {
+        uint64_t packets;
+        long long lastSeen;
+    };
+
+    std::vector<FlowBucket> buckets;
+    std::vector<FlowStats> stats;
+    uint32_t bucketShift;
+    long long idleTimeout;
+
+    uint8_t routeEpoch;
+    uint64_t routeVersion;
+
+    size_t flowCount;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t expirations;
+
+    const FlowEntry& entryAt(uint32_t slot) const;
+    FlowEntry& entryAt(uint32_t slot);
+};
+
+#endif
@@ -0,0 +1,328 @@
+#ifndef FORWARDINGPOLICY_H
+#define FORWARDINGPOLICY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <vector>
+#include "Packets.h"
+#include "FlowTable.h"
+#include "ForwardingTable.h"
+#include "qoservice.h"
+
+// Forwarding paths specialized at compile time for a fixed configuration.
+//
+// A policy fixes the QoS classes as a constexpr table of port ranges; the
+// scheduler and the FIB backend are template parameters. ForwardingPath
+// instantiates classify -> queue -> schedule -> route for one such
+// combination, so the class count, boundaries and backend calls are known
+// to the compiler: no classifier or flow-table checks, fixed ring queues
+// instead of deques and inlined lookups. RuntimeForwardingPath puts the
+// runtime-configured QoService behind the same interface and remains the
+// path for rule files and anything else only known at startup.
+//
+// Everything here is inline so each instantiation is compiled as one loop.
+
+struct PortClassRange {
+    int low;
+    int high;
+    int qosClass;
+};
+
+// Well-known, registered and dynamic ports, as QoService::classifyPort.
+// Another policy only needs the same members.
+struct PortRangePolicy {
+    static constexpr int CLASS_COUNT = 3;
+    static constexpr int DEFAULT_CLASS = QoService::LOW_PRIORITY;
+    static constexpr PortClassRange RANGES[] = {
+        { 0, 1023, QoService::HIGH_PRIORITY },
+        { 1024, 49151, QoService::MEDIUM_PRIORITY },
+        { 49152, 65535, QoService::LOW_PRIORITY }
+    };
+    static constexpr const char* NAMES[] = { "High", "Medium", "Low" };
+};
+
+// Ranges must be ascending and disjoint, and name valid classes
+template<typename Policy>
+constexpr bool isValidPolicy() {
+    if (Policy::CLASS_COUNT < 1 || Policy::CLASS_COUNT > 32 ||
+        Policy::DEFAULT_CLASS < 0 || Policy::DEFAULT_CLASS >= Policy::CLASS_COUNT) {
+        return false;
+    }
+    int previousHigh = -1;
+    for (const PortClassRange& range : Policy::RANGES) {
+        if (range.low <= previousHigh || range.high < range.low ||
+            range.qosClass < 0 || range.qosClass >= Policy::CLASS_COUNT) {
+            return false;
+        }
+        previousHigh = range.high;
+    }
+    return true;
+}
+
+// Time Complexity: O(r) for r ranges, unrolled at compile time
+template<typename Policy>
+constexpr int classifyPort(int port) {
+    for (const PortClassRange& range : Policy::RANGES) {
+        if (port >= range.low && port <= range.high) {
+            return range.qosClass;
+        }
+    }
+    return Policy::DEFAULT_CLASS;
+}
+
+// Serves the lowest backlogged class first, as QoService does
+template<int ClassCount>
+struct StrictPriorityScheduler {
+    int select(uint32_t backlogged) {
+        for (int qosClass = 0; qosClass < ClassCount; qosClass++) {
+            if (backlogged & (1u << qosClass)) {
+                return qosClass;
+            }
+        }
+        return -1;
+    }
+};
+
+// Serves the backlogged classes in turn, one packet each
+template<int ClassCount>
+struct RoundRobinScheduler {
+    int last = ClassCount - 1;
+
+    int select(uint32_t backlogged) {
+        for (int step = 1; step <= ClassCount; step++) {
+            int qosClass = (last + step) % ClassCount;
+            if (backlogged & (1u << qosClass)) {
+                last = qosClass;
+                return qosClass;
+            }
+        }
+        return -1;
+    }
+};
+
+// FIB lookup and ECMP member selection for every packet
+class CompiledFib {
+public:
+    explicit CompiledFib(const ForwardingTable* table)
+        : table(table) {
+    }
+
+    uint32_t route(packets& packet, long long) {
+        uint32_t group = table->lookup(packet.getDestinationAddress());
+        if (group == ForwardingTable::NO_ROUTE) {
+            return ForwardingTable::NO_ROUTE;
+        }
+        return table->selectMember(group, FlowTable::flowHash(packet.getSourceAddress(),
+            packet.getDestinationAddress(), static_cast<uint16_t>(packet.getPort())));
+    }
+
+private:
+    const ForwardingTable* table;
+};
+
+// Caches the forwarding decision per flow, so only the first packet of a
+// flow (or the first after a FIB change) does a lookup. A packet without a
+// valid slot was not seen by QoService, so it is counted against its flow
+// here; that keeps LRU eviction and idle expiry right on the compiled path.
+class FlowCachedFib {
+public:
+    FlowCachedFib(FlowTable* flows, const ForwardingTable* table)
+        : flows(flows), table(table) {
+    }
+
+    uint32_t route(packets& packet, long long now) {
+        uint32_t source = packet.getSourceAddress();
+        uint32_t destination = packet.getDestinationAddress();
+        uint16_t port = static_cast<uint16_t>(packet.getPort());
+
+        if (flows->getRouteVersion() != table->getVersion()) {
+            flows->invalidateRoutes(table->getVersion());
+        }
+
+        uint32_t hash = FlowTable::flowHash(source, destination, port);
+        uint32_t slot = packet.getFlowSlot();
+        if (slot == FlowTable::NO_SLOT || !flows->matches(slot, source, destination, port)) {
+            slot = flows->acquire(source, destination, port, hash, now);
+            flows->recordPacket(slot, now);
+            packet.setFlowSlot(slot);
+        }
+
+        uint32_t member = ForwardingTable::NO_ROUTE;
+        if (!flows->getCachedMember(slot, member)) {
+            uint32_t group = table->lookup(destination);
+            if (group != ForwardingTable::NO_ROUTE) {
+                member = table->selectMember(group, hash);
+            }
+            flows->setCachedMember(slot, member);
+        }
+        return member;
+    }
+
+private:
+    FlowTable* flows;
+    const ForwardingTable* table;
+};
+
+// Per-class ring queues of a fixed capacity, allocated once from the given
+// memory resource; a bitmask of backlogged classes feeds the scheduler.
+template<typename Policy, template<int> class Scheduler, typename Fib>
+class ForwardingPath {
+public:
+    static constexpr int CLASS_COUNT = Policy::CLASS_COUNT;
+    static_assert(isValidPolicy<Policy>(), "policy ranges must be ascending, disjoint and name valid classes");
+
+    ForwardingPath(const Fib& fib, int capacity,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : fib(fib), capacity(capacity > 0 ? static_cast<uint32_t>(capacity) : 1),
+        slots(static_cast<size_t>(CLASS_COUNT) * (capacity > 0 ? capacity : 1), resource),
+        backlogged(0), totalQueueDelay(0), dequeuedCount(0) {
+        for (int qosClass = 0; qosClass < CLASS_COUNT; qosClass++) {
+            heads[qosClass] = 0;
+            counts[qosClass] = 0;
+            classDequeued[qosClass] = 0;
+            classDropped[qosClass] = 0;
+        }
+    }
+
+    // Returns false when the class queue is full (tail drop)
+    bool enqueuePacket(packets& packet, long long now) {
+        int qosClass = classifyPort<Policy>(packet.getPort());
+        packet.setQosClass(qosClass);
+        packet.setPriority(Policy::NAMES[qosClass]);
+        if (counts[qosClass] == capacity) {
+            classDropped[qosClass]++;
+            return false;
+        }
+
+        packet.markEnqueued(now);
+        uint32_t tail = heads[qosClass] + counts[qosClass];
+        if (tail >= capacity) {
+            tail -= capacity;
+        }
+        slots[qosClass * capacity + tail] = packet;
+        counts[qosClass]++;
+        backlogged |= 1u << qosClass;
+        return true;
+    }
+
+    // Returns false when every queue is empty
+    bool dequeuePacket(packets& packet, long long now) {
+        int qosClass = scheduler.select(backlogged);
+        if (qosClass < 0) {
+            return false;
+        }
+
+        // A copy, so the slot keeps its string buffers for the next packet
+        packet = slots[qosClass * capacity + heads[qosClass]];
+        if (++heads[qosClass] == capacity) {
+            heads[qosClass] = 0;
+        }
+        if (--counts[qosClass] == 0) {
+            backlogged &= ~(1u << qosClass);
+        }
+
+        packet.markDequeued(now);
+        totalQueueDelay += packet.getQueueDelay();
+        dequeuedCount++;
+        classDequeued[qosClass]++;
+        return true;
+    }
+
+    uint32_t routePacket(packets& packet, long long now) {
+        return fib.route(packet, now);
+    }
+
+    bool allQueuesEmpty() const {
+        return backlogged == 0;
+    }
+
+    long long getAverageQueueDelay() const {
+        return dequeuedCount == 0 ? 0 : totalQueueDelay / dequeuedCount;
+    }
+
+    long long getDequeuedCount(int qosClass) const {
+        return classDequeued[qosClass];
+    }
+
+    long long getDroppedCount(int qosClass) const {
+        return classDropped[qosClass];
+    }
+
+    void displayQueueStatus() const {
+        std::cout << "Queue Status -";
+        for (int qosClass = 0; qosClass < CLASS_COUNT; qosClass++) {
+            std::cout << " " << Policy::NAMES[qosClass] << ":" << counts[qosClass];
+        }
+        std::cout << std::endl;
+    }
+
+private:
+    Fib fib;
+    Scheduler<CLASS_COUNT> scheduler;
+    uint32_t capacity;
+    std::pmr::vector<packets> slots;    // class-major, capacity per class
+    uint32_t heads[CLASS_COUNT];
+    uint32_t counts[CLASS_COUNT];
+    uint32_t backlogged;
+
+    long long totalQueueDelay;
+    long long dequeuedCount;
+    long long classDequeued[CLASS_COUNT];
+    long long classDropped[CLASS_COUNT];
+};
+
+// The runtime-configured fallback: QoService with whatever classifier and
+// flow table it was given, routed through a flow-cached FIB
+class RuntimeForwardingPath {
+public:
+    RuntimeForwardingPath(QoService* qos, const FlowCachedFib& fib)
+        : qos(qos), fib(fib) {
+    }
+
+    bool enqueuePacket(packets& packet, long long now) {
+        return qos->enqueuePacket(packet, now);
+    }
+
+    bool dequeuePacket(packets& packet, long long now) {
+        if (qos->allQueuesEmpty()) {
+            return false;
+        }
+        packet = qos->getNextPacket(now);
+        return packet.getId() != 0;
+    }
+
+    uint32_t routePacket(packets& packet, long long now) {
+        return fib.route(packet, now);
+    }
+
+    bool allQueuesEmpty() const {
+        return qos->allQueuesEmpty();
+    }
+
+    long long getAverageQueueDelay() const {
+        return qos->getAverageQueueDelay();
+    }
+
+    long long getDequeuedCount(int qosClass) const {
+        return qos->getDequeuedCount(qosClass);
+    }
+
+    long long getDroppedCount(int qosClass) const {
+        return qos->getDroppedCount(qosClass);
+    }
+
+    void displayQueueStatus() const {
+        qos->displayQueueStatus();
+    }
+
+private:
+    QoService* qos;
+    FlowCachedFib fib;
+};
+
+// The fixed configuration RouterDriver uses when no QoS rules are loaded
+typedef ForwardingPath<PortRangePolicy, StrictPriorityScheduler, FlowCachedFib> DefaultForwardingPath;
+
+#endif
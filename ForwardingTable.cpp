@@ -0,0 +1,1001 @@
+#include "ForwardingTable.h"
+#include "IPAddress.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+    // Ends in the two digits of ForwardingTable::SNAPSHOT_VERSION
+    const char SNAPSHOT_MAGIC[8] = { 'R', 'T', 'R', 'F', 'I', 'B', '0', '4' };
+    const uint64_t SECTION_ALIGNMENT = 64;
+
+    uint64_t alignUp(uint64_t offset) {
+        return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+
+    // Appends a range, folding it into the previous one when the group
+    // does not change. A range starting where the last one starts replaces
+    // it (adjacent updated regions meet at such a boundary).
+    void appendRange(vector<uint32_t>& starts, vector<uint32_t>& groups, uint64_t start, uint32_t group) {
+        if (!starts.empty() && starts.back() == start) {
+            starts.pop_back();
+            groups.pop_back();
+        }
+        if (!groups.empty() && groups.back() == group) {
+            return;
+        }
+        starts.push_back(static_cast<uint32_t>(start));
+        groups.push_back(group);
+    }
+
+    // Copies an untouched stretch of already-merged ranges; only its first
+    // range can fold into what precedes it, the rest is a bulk copy.
+    void copyRanges(vector<uint32_t>& starts, vector<uint32_t>& groups,
+        const uint32_t* fromStarts, const uint32_t* fromGroups, size_t first, size_t last) {
+        if (first >= last) {
+            return;
+        }
+        appendRange(starts, groups, fromStarts[first], fromGroups[first]);
+        starts.insert(starts.end(), fromStarts + first + 1, fromStarts + last);
+        groups.insert(groups.end(), fromGroups + first + 1, fromGroups + last);
+    }
+
+    // splitmix64 finalizer: cheap, well-distributed 64-bit mixing.
+    uint64_t mix64(uint64_t value) {
+        value ^= value >> 30;
+        value *= 0xBF58476D1CE4E5B9ull;
+        value ^= value >> 27;
+        value *= 0x94D049BB133111EBull;
+        value ^= value >> 31;
+        return value;
+    }
+
+    // Stored values must index the array they point into
+    bool allBelow(const uint32_t* values, size_t count, uint32_t limit) {
+        for (size_t i = 0; i < count; i++) {
+            if (values[i] >= limit) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool isAscending(const uint32_t* values, size_t count) {
+        for (size_t i = 1; i < count; i++) {
+            if (values[i] < values[i - 1]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int processId() {
+#ifdef _WIN32
+        return _getpid();
+#else
+        return static_cast<int>(getpid());
+#endif
+    }
+
+    uint64_t hashName(const string& name) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (char c : name) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+}
+
+// indexBits is clamped to 1..16; the index has 2^indexBits + 1 entries.
+ForwardingTable::ForwardingTable(int indexBits)
+    : buckets(nullptr), rangeStarts(nullptr), rangeGroups(nullptr), nameOffsets(nullptr),
+    names(nullptr), groupOffsets(nullptr), groupMembers(nullptr), groupBuckets(nullptr),
+    mappedPrefixes(nullptr), routeCount(0), rangeCount(0), hopCount(0), groupCount(0), version(0) {
+    this->indexBits = static_cast<uint32_t>(indexBits < 1 ? 1 : (indexBits > 16 ? 16 : indexBits));
+    bucketCount = (1u << this->indexBits) + 1;
+    RoutingTable empty;
+    build(empty);
+}
+
+uint64_t ForwardingTable::prefixKey(uint32_t start, int length) {
+    return (static_cast<uint64_t>(start) << 8) | static_cast<uint64_t>(length);
+}
+
+uint32_t ForwardingTable::internNextHop(const string& nextHop) {
+    auto found = hopIndex.find(nextHop);
+    if (found != hopIndex.end()) {
+        return found->second;
+    }
+
+    uint32_t hop = static_cast<uint32_t>(hopIndex.size());
+    hopIndex.emplace(nextHop, hop);
+    nameStore += nextHop;
+    nameOffsetStore.push_back(static_cast<uint32_t>(nameStore.size()));
+    hopCount = hop + 1;
+    names = nameStore.data();
+    nameOffsets = nameOffsetStore.data();
+    return hop;
+}
+
+// Groups are interned by their sorted member set. Each bucket goes to the
+// member with the highest hash(bucket, member name) that is still below its
+// fair share; scoring on names rather than indices keeps bucket ownership
+// stable when the member set changes. An empty set is no group: NO_ROUTE.
+// A new group starts unreferenced; retainGroup() it for each prefix using it.
+// Time Complexity: O(m log m + B * m) for m members, B buckets
+uint32_t ForwardingTable::internGroup(const vector<string>& nextHops) {
+    if (nextHops.empty()) {
+        return NO_ROUTE;
+    }
+
+    vector<uint32_t> members;
+    for (const auto& nextHop : nextHops) {
+        members.push_back(internNextHop(nextHop));
+    }
+    sort(members.begin(), members.end());
+    members.erase(unique(members.begin(), members.end()), members.end());
+
+    auto found = groupIndex.find(members);
+    if (found != groupIndex.end()) {
+        return found->second;
+    }
+
+    vector<uint64_t> memberHashes;
+    for (uint32_t hop : members) {
+        memberHashes.push_back(hashName(getNextHop(hop)));
+    }
+
+    uint32_t capacity = (GROUP_BUCKETS + static_cast<uint32_t>(members.size()) - 1)
+        / static_cast<uint32_t>(members.size());
+    vector<uint32_t> load(members.size(), 0);
+
+    for (uint32_t bucket = 0; bucket < GROUP_BUCKETS; bucket++) {
+        uint64_t bucketSeed = (bucket + 1) * 0x9E3779B97F4A7C15ull;
+        uint32_t bestSlot = 0;
+        uint64_t bestScore = 0;
+        bool found = false;
+        for (uint32_t slot = 0; slot < members.size(); slot++) {
+            uint64_t score = mix64(memberHashes[slot] ^ bucketSeed);
+            if (load[slot] < capacity && (!found || score > bestScore)) {
+                bestSlot = slot;
+                bestScore = score;
+                found = true;
+            }
+        }
+        load[bestSlot]++;
+        groupBucketStore.push_back(bestSlot);
+    }
+
+    uint32_t group = groupCount;
+    groupIndex.emplace(members, group);
+    groupMemberStore.insert(groupMemberStore.end(), members.begin(), members.end());
+    groupOffsetStore.push_back(static_cast<uint32_t>(groupMemberStore.size()));
+    memberPackets.resize(groupMemberStore.size(), 0);
+    groupRefs.push_back(0);
+    unusedGroups++;
+    groupCount = group + 1;
+
+    groupOffsets = groupOffsetStore.data();
+    groupMembers = groupMemberStore.data();
+    groupBuckets = groupBucketStore.data();
+    return group;
+}
+
+void ForwardingTable::retainGroup(uint32_t group) {
+    if (groupRefs[group]++ == 0) {
+        unusedGroups--;
+    }
+}
+
+void ForwardingTable::releaseGroup(uint32_t group) {
+    if (--groupRefs[group] == 0) {
+        unusedGroups++;
+    }
+}
+
+// Drops the groups no prefix uses any more, and the next hops only they
+// had, so announce/withdraw churn does not grow the group table without
+// bound. Survivors are renumbered in their old order, which keeps member
+// lists sorted and bucket tables valid as they are. Member numbers change,
+// so this must run under a version bump (flow caches drop their members).
+// Time Complexity: O(n + p + g * B) for n ranges, p prefixes, g groups
+void ForwardingTable::compactGroups() {
+    vector<uint32_t> hopMap(hopCount, NO_ROUTE);
+    for (uint32_t group = 0; group < groupCount; group++) {
+        if (groupRefs[group] > 0) {
+            for (uint32_t member = groupOffsets[group]; member < groupOffsets[group + 1]; member++) {
+                hopMap[groupMembers[member]] = 0;
+            }
+        }
+    }
+
+    string liveNames;
+    vector<uint32_t> liveNameOffsets(1, 0);
+    hopIndex.clear();
+    for (uint32_t hop = 0; hop < hopCount; hop++) {
+        if (hopMap[hop] != NO_ROUTE) {
+            hopMap[hop] = static_cast<uint32_t>(liveNameOffsets.size() - 1);
+            string name = getNextHop(hop);
+            hopIndex.emplace(name, hopMap[hop]);
+            liveNames += name;
+            liveNameOffsets.push_back(static_cast<uint32_t>(liveNames.size()));
+        }
+    }
+
+    vector<uint32_t> groupMap(groupCount, NO_ROUTE);
+    vector<uint32_t> liveOffsets(1, 0);
+    vector<uint32_t> liveMembers;
+    vector<uint32_t> liveBuckets;
+    vector<uint64_t> livePackets;
+    vector<uint32_t> liveRefs;
+    groupIndex.clear();
+    for (uint32_t group = 0; group < groupCount; group++) {
+        if (groupRefs[group] == 0) {
+            continue;
+        }
+        groupMap[group] = static_cast<uint32_t>(liveRefs.size());
+        vector<uint32_t> members;
+        for (uint32_t member = groupOffsets[group]; member < groupOffsets[group + 1]; member++) {
+            members.push_back(hopMap[groupMembers[member]]);
+            livePackets.push_back(memberPackets[member]);
+        }
+        liveMembers.insert(liveMembers.end(), members.begin(), members.end());
+        liveOffsets.push_back(static_cast<uint32_t>(liveMembers.size()));
+        liveBuckets.insert(liveBuckets.end(), groupBuckets + static_cast<size_t>(group) * GROUP_BUCKETS,
+            groupBuckets + static_cast<size_t>(group + 1) * GROUP_BUCKETS);
+        liveRefs.push_back(groupRefs[group]);
+        groupIndex.emplace(members, groupMap[group]);
+    }
+
+    for (auto& range : rangeGroupStore) {
+        if (range != NO_ROUTE) {
+            range = groupMap[range];
+        }
+    }
+    for (auto& pair : prefixIndex) {
+        pair.second.group = groupMap[pair.second.group];
+    }
+
+    nameStore.swap(liveNames);
+    nameOffsetStore.swap(liveNameOffsets);
+    groupOffsetStore.swap(liveOffsets);
+    groupMemberStore.swap(liveMembers);
+    groupBucketStore.swap(liveBuckets);
+    memberPackets.swap(livePackets);
+    groupRefs.swap(liveRefs);
+    hopCount = static_cast<uint32_t>(nameOffsetStore.size() - 1);
+    groupCount = static_cast<uint32_t>(groupRefs.size());
+    unusedGroups = 0;
+    attachOwnedStorage();
+}
+
+void ForwardingTable::resetNextHops() {
+    hopIndex.clear();
+    groupIndex.clear();
+    nameStore.clear();
+    nameOffsetStore.assign(1, 0);
+    groupOffsetStore.assign(1, 0);
+    groupMemberStore.clear();
+    groupBucketStore.clear();
+    memberPackets.clear();
+    groupRefs.clear();
+    unusedGroups = 0;
+    hopCount = 0;
+    groupCount = 0;
+}
+
+// Time Complexity: O(r log r) for r routes
+void ForwardingTable::build(const RoutingTable& rib) {
+    image.close();
+    mappedPrefixes = nullptr;
+    prefixIndex.clear();
+    resetNextHops();
+
+    for (const auto& pair : rib.getRoutes()) {
+        const RouterEntry& entry = pair.second;
+        uint32_t address = 0;
+        if (!IPAddress::parse(entry.getNetworkPrefix(), address)) {
+            continue;
+        }
+
+        int length = entry.getPrefixLength();
+        uint64_t key = prefixKey(address & IPAddress::prefixMask(length), length);
+        PrefixRoute route;
+        route.group = internGroup(entry.getNextHops());
+        route.metric = entry.getMetric();
+        if (route.group == NO_ROUTE) {
+            continue;
+        }
+
+        auto existing = prefixIndex.find(key);
+        if (existing == prefixIndex.end()) {
+            prefixIndex.emplace(key, route);
+            retainGroup(route.group);
+        }
+        else if (route.metric < existing->second.metric) {
+            releaseGroup(existing->second.group);
+            retainGroup(route.group);
+            existing->second = route;
+        }
+    }
+
+    routeCount = static_cast<uint32_t>(prefixIndex.size());
+    rebuildRanges();
+    version++;
+}
+
+void ForwardingTable::rebuildRanges() {
+    rangeStartStore.clear();
+    rangeGroupStore.clear();
+    sweepRegion(0, 0, rangeStartStore, rangeGroupStore);
+    attachOwnedStorage();
+    buildBuckets();
+}
+
+// Emits the ranges covering one prefix region by sweeping the prefixes inside
+// it in (start, length) order: a stack holds the enclosing prefixes, so each
+// range inherits the group of its innermost covering prefix. Addresses not
+// covered inside the region fall back to the region's longest ancestor.
+// Time Complexity: O(p log r) for p prefixes inside the region
+void ForwardingTable::sweepRegion(uint32_t regionStart, int regionLength,
+    vector<uint32_t>& starts, vector<uint32_t>& groups) const {
+    uint32_t regionEnd = regionStart | ~IPAddress::prefixMask(regionLength);
+
+    uint32_t baseGroup = NO_ROUTE;
+    for (int length = regionLength - 1; length >= 0; length--) {
+        auto ancestor = prefixIndex.find(prefixKey(regionStart & IPAddress::prefixMask(length), length));
+        if (ancestor != prefixIndex.end()) {
+            baseGroup = ancestor->second.group;
+            break;
+        }
+    }
+
+    auto it = prefixIndex.lower_bound(prefixKey(regionStart, regionLength));
+    auto last = (regionEnd == 0xFFFFFFFFu) ? prefixIndex.end()
+        : prefixIndex.lower_bound(prefixKey(regionEnd + 1, 0));
+
+    vector<pair<uint32_t, uint32_t>> stack;
+    uint64_t cursor = regionStart;
+
+    for (; it != last; ++it) {
+        uint32_t start = static_cast<uint32_t>(it->first >> 8);
+        int length = static_cast<int>(it->first & 0xFF);
+        uint32_t end = start | ~IPAddress::prefixMask(length);
+
+        while (!stack.empty() && stack.back().first < start) {
+            if (cursor <= stack.back().first) {
+                appendRange(starts, groups, cursor, stack.back().second);
+            }
+            cursor = static_cast<uint64_t>(stack.back().first) + 1;
+            stack.pop_back();
+        }
+        if (cursor < start) {
+            appendRange(starts, groups, cursor, stack.empty() ? baseGroup : stack.back().second);
+        }
+        stack.push_back(make_pair(end, it->second.group));
+        cursor = start;
+    }
+
+    while (!stack.empty()) {
+        if (cursor <= stack.back().first) {
+            appendRange(starts, groups, cursor, stack.back().second);
+        }
+        cursor = static_cast<uint64_t>(stack.back().first) + 1;
+        stack.pop_back();
+    }
+    if (cursor <= regionEnd) {
+        appendRange(starts, groups, cursor, baseGroup);
+    }
+}
+
+// Applies a batch of announces/withdraws. An announce at the metric the
+// prefix already has joins its next hops to the equal-cost group, any other
+// metric replaces the route, as RoutingTable::addRoute does for the RIB.
+// Only the address space under the
+// updated prefixes can change its longest match, so those regions (reduced
+// to the outermost ones) are re-swept. Neighbouring regions share a window
+// that also takes the old range on either side, so the seams fold; each
+// window then replaces exactly the old ranges it was built from, in place.
+// Only the index buckets inside a window are looked up again; the ones after
+// a window that changed the range count are shifted by the difference.
+// Time Complexity: O(u log r + p + w log n) for u updates, p prefixes inside
+// the updated regions and w rebuilt buckets, plus one move of the ranges
+// after the first window whose size changed
+void ForwardingTable::applyUpdates(const vector<RouteUpdate>& batch) {
+    if (batch.empty()) {
+        return;
+    }
+    copyImageToOwnedStorage();
+
+    vector<pair<uint32_t, int>> regions;
+    regions.reserve(batch.size());
+
+    for (const auto& update : batch) {
+        uint32_t start = update.prefix & IPAddress::prefixMask(update.prefixLength);
+        uint64_t key = prefixKey(start, update.prefixLength);
+
+        auto existing = prefixIndex.find(key);
+        if (update.announce) {
+            PrefixRoute route;
+            route.metric = update.metric;
+            if (existing != prefixIndex.end() && existing->second.metric == update.metric) {
+                vector<string> nextHops = update.nextHops;
+                uint32_t group = existing->second.group;
+                for (uint32_t member = groupOffsets[group]; member < groupOffsets[group + 1]; member++) {
+                    nextHops.push_back(getNextHop(groupMembers[member]));
+                }
+                route.group = internGroup(nextHops);
+            }
+            else {
+                route.group = internGroup(update.nextHops);
+            }
+            if (route.group == NO_ROUTE) {
+                continue;
+            }
+
+            retainGroup(route.group);
+            if (existing != prefixIndex.end()) {
+                releaseGroup(existing->second.group);
+                existing->second = route;
+            }
+            else {
+                prefixIndex.emplace(key, route);
+            }
+        }
+        else if (existing != prefixIndex.end()) {
+            releaseGroup(existing->second.group);
+            prefixIndex.erase(existing);
+        }
+        else {
+            continue;
+        }
+        regions.push_back(make_pair(start, update.prefixLength));
+    }
+    routeCount = static_cast<uint32_t>(prefixIndex.size());
+
+    if (regions.empty()) {
+        return;
+    }
+    version++;
+    sort(regions.begin(), regions.end());
+
+    vector<RangeSplice> splices;
+    vector<uint32_t> starts;
+    vector<uint32_t> groups;
+
+    size_t index = 0;
+    bool haveRegion = false;
+    uint64_t coveredEnd = 0;
+
+    // Ends the open window with the old range to its right
+    auto closeWindow = [&]() {
+        if (index < rangeCount) {
+            copyRanges(starts, groups, rangeStarts, rangeGroups, index, index + 1);
+            index++;
+        }
+        RangeSplice& splice = splices.back();
+        splice.last = index;
+        splice.contentLast = starts.size();
+        splice.spanLast = index < rangeCount ? rangeStarts[index] - 1 : 0xFFFFFFFFu;
+    };
+
+    for (const auto& region : regions) {
+        uint32_t regionEnd = region.first | ~IPAddress::prefixMask(region.second);
+        if (haveRegion && region.first <= coveredEnd) {
+            continue;
+        }
+        haveRegion = true;
+        coveredEnd = regionEnd;
+
+        size_t stretchEnd = lower_bound(rangeStarts + index, rangeStarts + rangeCount, region.first) - rangeStarts;
+        size_t windowStart = stretchEnd > 0 ? stretchEnd - 1 : 0;
+
+        if (!splices.empty() && windowStart <= index) {
+            copyRanges(starts, groups, rangeStarts, rangeGroups, index, stretchEnd);
+        }
+        else {
+            if (!splices.empty()) {
+                closeWindow();
+            }
+            RangeSplice splice;
+            splice.first = windowStart;
+            splice.contentFirst = starts.size();
+            splice.spanFirst = rangeStarts[windowStart];
+            splices.push_back(splice);
+
+            // Pushed, not appended: it must not fold into the previous window
+            if (windowStart < stretchEnd) {
+                starts.push_back(rangeStarts[windowStart]);
+                groups.push_back(rangeGroups[windowStart]);
+            }
+        }
+        index = stretchEnd;
+
+        sweepRegion(region.first, region.second, starts, groups);
+
+        if (regionEnd == 0xFFFFFFFFu) {
+            index = rangeCount;
+            break;
+        }
+        index = upper_bound(rangeStarts + index, rangeStarts + rangeCount, regionEnd + 1) - rangeStarts;
+        appendRange(starts, groups, static_cast<uint64_t>(regionEnd) + 1, rangeGroups[index - 1]);
+    }
+    closeWindow();
+
+    spliceRanges(splices, starts, groups);
+    if (unusedGroups > groupCount / 2) {
+        compactGroups();
+    }
+}
+
+// Replaces each window's old ranges with its content. Untouched stretches
+// that move left are moved front to back, then those that move right back
+// to front, so none overwrites one still to be moved; the content fills the
+// gaps last.
+void ForwardingTable::spliceRanges(const vector<RangeSplice>& splices,
+    const vector<uint32_t>& starts, const vector<uint32_t>& groups) {
+    size_t oldCount = rangeCount;
+    vector<long long> shifts(splices.size());
+    long long shift = 0;
+    for (size_t i = 0; i < splices.size(); i++) {
+        shift += static_cast<long long>(splices[i].contentLast - splices[i].contentFirst)
+            - static_cast<long long>(splices[i].last - splices[i].first);
+        shifts[i] = shift;
+    }
+    size_t newCount = static_cast<size_t>(static_cast<long long>(oldCount) + shift);
+
+    if (newCount > oldCount) {
+        rangeStartStore.resize(newCount);
+        rangeGroupStore.resize(newCount);
+    }
+
+    // The stretch after splice i is [last, next first), moved by shifts[i]
+    auto moveStretch = [&](size_t i) {
+        size_t first = splices[i].last;
+        size_t last = i + 1 < splices.size() ? splices[i + 1].first : oldCount;
+        if (first < last && shifts[i] != 0) {
+            size_t target = static_cast<size_t>(static_cast<long long>(first) + shifts[i]);
+            memmove(&rangeStartStore[target], &rangeStartStore[first], (last - first) * sizeof(uint32_t));
+            memmove(&rangeGroupStore[target], &rangeGroupStore[first], (last - first) * sizeof(uint32_t));
+        }
+    };
+    for (size_t i = 0; i < splices.size(); i++) {
+        if (shifts[i] < 0) {
+            moveStretch(i);
+        }
+    }
+    for (size_t i = splices.size(); i-- > 0;) {
+        if (shifts[i] > 0) {
+            moveStretch(i);
+        }
+    }
+    for (size_t i = 0; i < splices.size(); i++) {
+        size_t target = static_cast<size_t>(static_cast<long long>(splices[i].first) + (i > 0 ? shifts[i - 1] : 0));
+        copy(starts.begin() + splices[i].contentFirst, starts.begin() + splices[i].contentLast,
+            rangeStartStore.begin() + target);
+        copy(groups.begin() + splices[i].contentFirst, groups.begin() + splices[i].contentLast,
+            rangeGroupStore.begin() + target);
+    }
+
+    if (newCount < oldCount) {
+        rangeStartStore.resize(newCount);
+        rangeGroupStore.resize(newCount);
+    }
+    attachOwnedStorage();
+
+    // Buckets inside a window's address span are looked up again; the ones
+    // between windows point at untouched ranges and only shift
+    uint32_t addressShift = 32 - indexBits;
+    size_t nextBucket = 0;
+    shift = 0;
+    for (size_t i = 0; i < splices.size(); i++) {
+        size_t firstBucket = static_cast<size_t>(
+            (static_cast<uint64_t>(splices[i].spanFirst) + (1ull << addressShift) - 1) >> addressShift);
+        size_t lastBucket = splices[i].spanLast == 0xFFFFFFFFu ? bucketCount - 1
+            : splices[i].spanLast >> addressShift;
+
+        if (shift != 0) {
+            for (size_t bucket = nextBucket; bucket < firstBucket; bucket++) {
+                bucketStore[bucket] = static_cast<uint32_t>(bucketStore[bucket] + shift);
+            }
+        }
+        for (size_t bucket = firstBucket; bucket <= lastBucket; bucket++) {
+            uint32_t address = (bucket == bucketCount - 1) ? 0xFFFFFFFFu
+                : static_cast<uint32_t>(bucket << addressShift);
+            bucketStore[bucket] = static_cast<uint32_t>(
+                upper_bound(rangeStarts, rangeStarts + rangeCount, address) - rangeStarts - 1);
+        }
+        nextBucket = max(nextBucket, lastBucket + 1);
+        shift = shifts[i];
+    }
+    if (shift != 0) {
+        for (size_t bucket = nextBucket; bucket < bucketCount; bucket++) {
+            bucketStore[bucket] = static_cast<uint32_t>(bucketStore[bucket] + shift);
+        }
+    }
+}
+
+// bucket[b] is the range containing address b << (32 - indexBits), so any
+// address in bucket b resolves to a range in [bucket[b], bucket[b + 1]].
+void ForwardingTable::buildBuckets() {
+    bucketStore.resize(bucketCount);
+    uint32_t range = 0;
+
+    for (uint32_t bucket = 0; bucket < bucketCount; bucket++) {
+        uint32_t address = (bucket == bucketCount - 1) ? 0xFFFFFFFFu : (bucket << (32 - indexBits));
+        while (range + 1 < rangeCount && rangeStarts[range + 1] <= address) {
+            range++;
+        }
+        bucketStore[bucket] = range;
+    }
+    buckets = bucketStore.data();
+}
+
+void ForwardingTable::attachOwnedStorage() {
+    rangeCount = static_cast<uint32_t>(rangeStartStore.size());
+    rangeStarts = rangeStartStore.data();
+    rangeGroups = rangeGroupStore.data();
+    nameOffsets = nameOffsetStore.data();
+    names = nameStore.data();
+    buckets = bucketStore.data();
+    groupOffsets = groupOffsetStore.data();
+    groupMembers = groupMemberStore.data();
+    groupBuckets = groupBucketStore.data();
+}
+
+// The first update after a snapshot load copies the image into owned
+// storage and rebuilds the prefix index; lookups before that stay on the
+// shared read-only pages.
+void ForwardingTable::copyImageToOwnedStorage() {
+    if (!image.isOpen()) {
+        return;
+    }
+
+    rangeStartStore.assign(rangeStarts, rangeStarts + rangeCount);
+    rangeGroupStore.assign(rangeGroups, rangeGroups + rangeCount);
+    bucketStore.assign(buckets, buckets + bucketCount);
+    nameOffsetStore.assign(nameOffsets, nameOffsets + hopCount + 1);
+    nameStore.assign(names, nameOffsets[hopCount]);
+    groupOffsetStore.assign(groupOffsets, groupOffsets + groupCount + 1);
+    groupMemberStore.assign(groupMembers, groupMembers + groupOffsets[groupCount]);
+    groupBucketStore.assign(groupBuckets, groupBuckets + static_cast<size_t>(groupCount) * GROUP_BUCKETS);
+
+    hopIndex.clear();
+    for (uint32_t hop = 0; hop < hopCount; hop++) {
+        hopIndex.emplace(getNextHop(hop), hop);
+    }
+
+    groupIndex.clear();
+    for (uint32_t group = 0; group < groupCount; group++) {
+        vector<uint32_t> members(groupMembers + groupOffsets[group], groupMembers + groupOffsets[group + 1]);
+        groupIndex.emplace(members, group);
+    }
+
+    groupRefs.assign(groupCount, 0);
+    unusedGroups = groupCount;
+    prefixIndex.clear();
+    for (uint32_t i = 0; i < routeCount; i++) {
+        const SnapshotPrefix& prefix = mappedPrefixes[i];
+        PrefixRoute route;
+        route.group = prefix.group;
+        route.metric = prefix.metric;
+        prefixIndex.emplace_hint(prefixIndex.end(), prefixKey(prefix.start, prefix.length), route);
+        retainGroup(prefix.group);
+    }
+
+    mappedPrefixes = nullptr;
+    image.close();
+    attachOwnedStorage();
+}
+
+// Time Complexity: O(log k) where k = ranges inside one index bucket
+uint32_t ForwardingTable::lookup(uint32_t address) const {
+    uint32_t bucket = address >> (32 - indexBits);
+    uint32_t low = buckets[bucket];
+    uint32_t high = buckets[bucket + 1];
+
+    while (low < high) {
+        uint32_t mid = low + (high - low + 1) / 2;
+        if (rangeStarts[mid] <= address) {
+            low = mid;
+        }
+        else {
+            high = mid - 1;
+        }
+    }
+    return rangeGroups[low];
+}
+
+// Returns the group member owning the flow's bucket. Members are numbered
+// across all groups, so the result can be cached per flow and later passed
+// to recordForward(). Time Complexity: O(1)
+uint32_t ForwardingTable::selectMember(uint32_t group, uint32_t flowHash) const {
+    uint32_t first = groupOffsets[group];
+    if (groupOffsets[group + 1] - first == 1) {
+        return first;
+    }
+    return first + groupBuckets[static_cast<size_t>(group) * GROUP_BUCKETS + (flowHash % GROUP_BUCKETS)];
+}
+
+// Counts a packet against the member and returns its next-hop index.
+uint32_t ForwardingTable::recordForward(uint32_t member) {
+    memberPackets[member]++;
+    return groupMembers[member];
+}
+
+string ForwardingTable::getNextHop(uint32_t hopIndex) const {
+    if (hopIndex >= hopCount) {
+        return "";
+    }
+    return string(names + nameOffsets[hopIndex], nameOffsets[hopIndex + 1] - nameOffsets[hopIndex]);
+}
+
+// Image layout: header, then each array at a 64-byte aligned offset from the
+// start of the file. Offsets rather than pointers keep the image position
+// independent; integers are stored in host byte order. The prefix section
+// lets a mapped table accept incremental updates without the route file.
+// The image is written to a temporary file and renamed over the old one:
+// other processes may have it mapped, and truncating it under them would
+// fault their lookups. They keep the old image until they map it again.
+bool ForwardingTable::saveSnapshot(const string& filename, uint64_t sourceVersion) const {
+    vector<SnapshotPrefix> prefixes;
+    if (mappedPrefixes != nullptr) {
+        prefixes.assign(mappedPrefixes, mappedPrefixes + routeCount);
+    }
+    else {
+        prefixes.reserve(prefixIndex.size());
+        for (const auto& pair : prefixIndex) {
+            SnapshotPrefix prefix;
+            prefix.start = static_cast<uint32_t>(pair.first >> 8);
+            prefix.length = static_cast<uint32_t>(pair.first & 0xFF);
+            prefix.group = pair.second.group;
+            prefix.metric = pair.second.metric;
+            prefixes.push_back(prefix);
+        }
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.routeCount = static_cast<uint32_t>(prefixes.size());
+    header.rangeCount = rangeCount;
+    header.hopCount = hopCount;
+    header.sourceVersion = sourceVersion;
+    header.bucketOffset = alignUp(sizeof(SnapshotHeader));
+    header.indexBits = indexBits;
+    header.rangeStartOffset = alignUp(header.bucketOffset + bucketCount * sizeof(uint32_t));
+    header.rangeGroupOffset = alignUp(header.rangeStartOffset + rangeCount * sizeof(uint32_t));
+    header.nameOffsetOffset = alignUp(header.rangeGroupOffset + rangeCount * sizeof(uint32_t));
+    header.nameOffset = alignUp(header.nameOffsetOffset + (hopCount + 1) * sizeof(uint32_t));
+    header.nameSize = nameOffsets[hopCount];
+    header.prefixOffset = alignUp(header.nameOffset + header.nameSize);
+    header.groupCount = groupCount;
+    header.memberCount = groupOffsets[groupCount];
+    header.groupOffsetOffset = alignUp(header.prefixOffset + prefixes.size() * sizeof(SnapshotPrefix));
+    header.groupMemberOffset = alignUp(header.groupOffsetOffset + (groupCount + 1) * sizeof(uint32_t));
+    header.groupBucketOffset = alignUp(header.groupMemberOffset + header.memberCount * sizeof(uint32_t));
+    header.totalSize = header.groupBucketOffset + static_cast<uint64_t>(groupCount) * GROUP_BUCKETS * sizeof(uint32_t);
+
+    string tempName = filename + ".tmp" + to_string(processId());
+    ofstream file(tempName, ios::binary | ios::trunc);
+    if (!file.is_open()) {
+        cout << "Error: Cannot write FIB snapshot " << tempName << endl;
+        return false;
+    }
+
+    uint64_t written = 0;
+    auto writeSection = [&](uint64_t offset, const void* data, uint64_t size) {
+        static const char padding[SECTION_ALIGNMENT] = {};
+        file.write(padding, static_cast<streamsize>(offset - written));
+        file.write(static_cast<const char*>(data), static_cast<streamsize>(size));
+        written = offset + size;
+    };
+
+    writeSection(0, &header, sizeof(header));
+    writeSection(header.bucketOffset, buckets, bucketCount * sizeof(uint32_t));
+    writeSection(header.rangeStartOffset, rangeStarts, rangeCount * sizeof(uint32_t));
+    writeSection(header.rangeGroupOffset, rangeGroups, rangeCount * sizeof(uint32_t));
+    writeSection(header.nameOffsetOffset, nameOffsets, (hopCount + 1) * sizeof(uint32_t));
+    writeSection(header.nameOffset, names, header.nameSize);
+    writeSection(header.prefixOffset, prefixes.data(), prefixes.size() * sizeof(SnapshotPrefix));
+    writeSection(header.groupOffsetOffset, groupOffsets, (groupCount + 1) * sizeof(uint32_t));
+    writeSection(header.groupMemberOffset, groupMembers, header.memberCount * sizeof(uint32_t));
+    writeSection(header.groupBucketOffset, groupBuckets,
+        static_cast<uint64_t>(groupCount) * GROUP_BUCKETS * sizeof(uint32_t));
+
+    file.close();
+    error_code error;
+    if (!file) {
+        cout << "Error: Cannot write FIB snapshot " << tempName << endl;
+        filesystem::remove(tempName, error);
+        return false;
+    }
+
+    // Atomic on POSIX, even while other processes map the old image. On
+    // Windows the replace fails while any process has the image mapped;
+    // the old image then stays and the next start rebuilds it.
+    filesystem::rename(tempName, filename, error);
+    if (error) {
+        cout << "Error: Cannot replace FIB snapshot " << filename << ": " << error.message() << endl;
+        filesystem::remove(tempName, error);
+        return false;
+    }
+    return true;
+}
+
+// Maps the image read-only and points the lookup arrays straight into it;
+// nothing is copied or rebuilt. Every stored index is checked against the
+// array it points into first, so a damaged image is rejected (and rebuilt
+// from the route file) instead of sending lookups out of bounds.
+// Time Complexity: O(s) for an s-byte image, one sequential read
+bool ForwardingTable::loadSnapshot(const string& filename, uint64_t sourceVersion) {
+    MappedFile mapped;
+    if (!mapped.open(filename) || mapped.getSize() < sizeof(SnapshotHeader)) {
+        return false;
+    }
+
+    SnapshotHeader header;
+    memcpy(&header, mapped.getData(), sizeof(header));
+
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SNAPSHOT_VERSION ||
+        header.indexBits != indexBits ||
+        header.sourceVersion != sourceVersion ||
+        header.totalSize != mapped.getSize() ||
+        header.rangeCount == 0 ||
+        header.bucketOffset < sizeof(SnapshotHeader) ||
+        header.groupBucketOffset > header.totalSize ||
+        header.bucketOffset % SECTION_ALIGNMENT != 0 ||
+        header.rangeStartOffset % SECTION_ALIGNMENT != 0 ||
+        header.rangeGroupOffset % SECTION_ALIGNMENT != 0 ||
+        header.nameOffsetOffset % SECTION_ALIGNMENT != 0 ||
+        header.nameOffset % SECTION_ALIGNMENT != 0 ||
+        header.prefixOffset % SECTION_ALIGNMENT != 0 ||
+        header.groupOffsetOffset % SECTION_ALIGNMENT != 0 ||
+        header.groupMemberOffset % SECTION_ALIGNMENT != 0 ||
+        header.groupBucketOffset % SECTION_ALIGNMENT != 0 ||
+        header.rangeStartOffset < header.bucketOffset + bucketCount * sizeof(uint32_t) ||
+        header.rangeGroupOffset < header.rangeStartOffset + header.rangeCount * sizeof(uint32_t) ||
+        header.nameOffsetOffset < header.rangeGroupOffset + header.rangeCount * sizeof(uint32_t) ||
+        header.nameOffset < header.nameOffsetOffset + (header.hopCount + 1) * sizeof(uint32_t) ||
+        header.prefixOffset < header.nameOffset + header.nameSize ||
+        header.groupOffsetOffset < header.prefixOffset + header.routeCount * sizeof(SnapshotPrefix) ||
+        header.groupMemberOffset < header.groupOffsetOffset + (header.groupCount + 1) * sizeof(uint32_t) ||
+        header.groupBucketOffset < header.groupMemberOffset + header.memberCount * sizeof(uint32_t) ||
+        header.groupBucketOffset + static_cast<uint64_t>(header.groupCount) * GROUP_BUCKETS * sizeof(uint32_t)
+            != header.totalSize) {
+        return false;
+    }
+
+    const char* base = mapped.getData();
+    const uint32_t* mappedBuckets = reinterpret_cast<const uint32_t*>(base + header.bucketOffset);
+    const uint32_t* mappedStarts = reinterpret_cast<const uint32_t*>(base + header.rangeStartOffset);
+    const uint32_t* mappedGroups = reinterpret_cast<const uint32_t*>(base + header.rangeGroupOffset);
+    const uint32_t* mappedNameOffsets = reinterpret_cast<const uint32_t*>(base + header.nameOffsetOffset);
+    const SnapshotPrefix* prefixes = reinterpret_cast<const SnapshotPrefix*>(base + header.prefixOffset);
+    const uint32_t* mappedGroupOffsets = reinterpret_cast<const uint32_t*>(base + header.groupOffsetOffset);
+    const uint32_t* mappedMembers = reinterpret_cast<const uint32_t*>(base + header.groupMemberOffset);
+    const uint32_t* mappedGroupBuckets = reinterpret_cast<const uint32_t*>(base + header.groupBucketOffset);
+
+    if (mappedNameOffsets[0] != 0 || mappedNameOffsets[header.hopCount] != header.nameSize ||
+        !isAscending(mappedNameOffsets, header.hopCount + 1) ||
+        mappedGroupOffsets[0] != 0 || mappedGroupOffsets[header.groupCount] != header.memberCount ||
+        !isAscending(mappedGroupOffsets, header.groupCount + 1) ||
+        mappedStarts[0] != 0 || !isAscending(mappedStarts, header.rangeCount) ||
+        !isAscending(mappedBuckets, bucketCount) ||
+        !allBelow(mappedBuckets, bucketCount, header.rangeCount) ||
+        !allBelow(mappedMembers, header.memberCount, header.hopCount)) {
+        return false;
+    }
+
+    for (uint32_t range = 0; range < header.rangeCount; range++) {
+        if (mappedGroups[range] != NO_ROUTE && mappedGroups[range] >= header.groupCount) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header.routeCount; i++) {
+        if (prefixes[i].length > 32 || prefixes[i].group >= header.groupCount) {
+            return false;
+        }
+    }
+    for (uint32_t group = 0; group < header.groupCount; group++) {
+        uint32_t size = mappedGroupOffsets[group + 1] - mappedGroupOffsets[group];
+        if (size == 0 || !allBelow(mappedGroupBuckets + static_cast<size_t>(group) * GROUP_BUCKETS,
+            GROUP_BUCKETS, size)) {
+            return false;
+        }
+    }
+
+    image.swap(mapped);
+
+    prefixIndex.clear();
+    resetNextHops();
+    bucketStore.clear();
+    rangeStartStore.clear();
+    rangeGroupStore.clear();
+
+    buckets = mappedBuckets;
+    rangeStarts = mappedStarts;
+    rangeGroups = mappedGroups;
+    nameOffsets = mappedNameOffsets;
+    names = base + header.nameOffset;
+    mappedPrefixes = prefixes;
+    groupOffsets = mappedGroupOffsets;
+    groupMembers = mappedMembers;
+    groupBuckets = mappedGroupBuckets;
+    memberPackets.assign(header.memberCount, 0);
+    routeCount = header.routeCount;
+    rangeCount = header.rangeCount;
+    hopCount = header.hopCount;
+    groupCount = header.groupCount;
+    version++;
+    return true;
+}
+
+bool ForwardingTable::isMapped() const {
+    return image.isOpen();
+}
+
+uint64_t ForwardingTable::getVersion() const {
+    return version;
+}
+
+size_t ForwardingTable::getRouteCount() const {
+    return routeCount;
+}
+
+size_t ForwardingTable::getRangeCount() const {
+    return rangeCount;
+}
+
+size_t ForwardingTable::getNextHopCount() const {
+    return hopCount;
+}
+
+size_t ForwardingTable::getGroupCount() const {
+    return groupCount;
+}
+
+void ForwardingTable::displaySummary() const {
+    cout << "FIB: " << routeCount << " routes, " << rangeCount << " ranges, "
+        << hopCount << " next hops, " << groupCount << " groups"
+        << (isMapped() ? " (mapped snapshot)" : " (built in memory)") << endl;
+}
+
+void ForwardingTable::displayGroupStats() const {
+    for (uint32_t group = 0; group < groupCount; group++) {
+        uint32_t first = groupOffsets[group];
+        uint32_t last = groupOffsets[group + 1];
+        if (last - first < 2) {
+            continue;
+        }
+
+        uint64_t total = 0;
+        for (uint32_t member = first; member < last; member++) {
+            total += memberPackets[member];
+        }
+        if (total == 0) {
+            continue;
+        }
+
+        cout << "ECMP group " << group << ":";
+        for (uint32_t member = first; member < last; member++) {
+            cout << " " << getNextHop(groupMembers[member]) << "=" << memberPackets[member]
+                << " (" << (memberPackets[member] * 100 / total) << "%)";
+        }
+        cout << endl;
+    }
+}
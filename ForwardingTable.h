@@ -0,0 +1,162 @@
+#ifndef FORWARDINGTABLE_H
+#define FORWARDINGTABLE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MappedFile.h"
+#include "RouteUpdateStream.h"
+#include "RoutingTable.h"
+
+// Compiled lookup structure (FIB) built from the RoutingTable (RIB).
+//
+// The address space is flattened into disjoint ranges, each carrying the
+// next-hop group of its longest matching prefix, plus an index on the top
+// indexBits address bits (16 by default, 65537 entries) that narrows the
+// binary search to one bucket. Small tables, e.g. one per simulated router,
+// can use fewer bits to keep the index small.
+// Every section is a flat array addressed by file offset, so the same
+// layout is written to disk and mapped back read-only at startup.
+//
+// Ranges resolve to an equal-cost next-hop group. Each group owns a table of
+// GROUP_BUCKETS flow-hash buckets filled by rendezvous hashing on the member
+// names with a per-member load cap, so members get equal shares and adding
+// or removing one leaves almost every other flow on its current next hop.
+class ForwardingTable {
+public:
+    static constexpr uint32_t NO_ROUTE = 0xFFFFFFFFu;
+
+    ForwardingTable(int indexBits = 16);
+
+    ForwardingTable(const ForwardingTable&) = delete;
+    ForwardingTable& operator=(const ForwardingTable&) = delete;
+
+    void build(const RoutingTable& rib);
+    void applyUpdates(const std::vector<RouteUpdate>& batch);
+    uint32_t lookup(uint32_t address) const;
+    uint32_t selectMember(uint32_t group, uint32_t flowHash) const;
+    uint32_t recordForward(uint32_t member);
+    std::string getNextHop(uint32_t hopIndex) const;
+
+    bool saveSnapshot(const std::string& filename, uint64_t sourceVersion) const;
+    bool loadSnapshot(const std::string& filename, uint64_t sourceVersion);
+
+    bool isMapped() const;
+    uint64_t getVersion() const;
+    size_t getRouteCount() const;
+    size_t getRangeCount() const;
+    size_t getNextHopCount() const;
+    size_t getGroupCount() const;
+    void displaySummary() const;
+    void displayGroupStats() const;
+
+private:
+    struct SnapshotHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t routeCount;
+        uint32_t rangeCount;
+        uint32_t hopCount;
+        uint64_t sourceVersion;
+        uint64_t bucketOffset;
+        uint64_t rangeStartOffset;
+        uint64_t rangeGroupOffset;
+        uint64_t nameOffsetOffset;
+        uint64_t nameOffset;
+        uint64_t nameSize;
+        uint64_t prefixOffset;
+        uint32_t groupCount;
+        uint32_t memberCount;
+        uint32_t indexBits;
+        uint32_t reserved;
+        uint64_t groupOffsetOffset;
+        uint64_t groupMemberOffset;
+        uint64_t groupBucketOffset;
+        uint64_t totalSize;
+    };
+
+    struct SnapshotPrefix {
+        uint32_t start;
+        uint32_t length;
+        uint32_t group;
+        int32_t metric;
+    };
+
+    struct PrefixRoute {
+        uint32_t group;
+        int metric;
+    };
+
+    // Old ranges [first, last) are replaced by content [contentFirst,
+    // contentLast); both cover addresses spanFirst..spanLast.
+    struct RangeSplice {
+        size_t first;
+        size_t last;
+        size_t contentFirst;
+        size_t contentLast;
+        uint32_t spanFirst;
+        uint32_t spanLast;
+    };
+
+    typedef std::map<uint64_t, PrefixRoute> PrefixIndex;
+
+    static const uint32_t SNAPSHOT_VERSION = 4;
+    static const uint32_t GROUP_BUCKETS = 256;
+
+    // Prefixes keyed by (start << 8 | length), i.e. in sweep order. Only
+    // materialized from a mapped image once updates need it.
+    PrefixIndex prefixIndex;
+    std::unordered_map<std::string, uint32_t> hopIndex;
+    std::map<std::vector<uint32_t>, uint32_t> groupIndex;
+
+    std::vector<uint32_t> bucketStore;
+    std::vector<uint32_t> rangeStartStore;
+    std::vector<uint32_t> rangeGroupStore;
+    std::vector<uint32_t> nameOffsetStore;
+    std::string nameStore;
+    std::vector<uint32_t> groupOffsetStore;
+    std::vector<uint32_t> groupMemberStore;
+    std::vector<uint32_t> groupBucketStore;
+    std::vector<uint64_t> memberPackets;
+    std::vector<uint32_t> groupRefs;    // prefixes using each group
+    uint32_t unusedGroups;
+    MappedFile image;
+
+    const uint32_t* buckets;
+    const uint32_t* rangeStarts;
+    const uint32_t* rangeGroups;
+    const uint32_t* nameOffsets;
+    const char* names;
+    const uint32_t* groupOffsets;
+    const uint32_t* groupMembers;
+    const uint32_t* groupBuckets;
+    const SnapshotPrefix* mappedPrefixes;
+    uint32_t routeCount;
+    uint32_t rangeCount;
+    uint32_t hopCount;
+    uint32_t groupCount;
+    uint64_t version;
+    uint32_t indexBits;
+    uint32_t bucketCount;
+
+    static uint64_t prefixKey(uint32_t start, int length);
+
+    uint32_t internNextHop(const std::string& nextHop);
+    uint32_t internGroup(const std::vector<std::string>& nextHops);
+    void retainGroup(uint32_t group);
+    void releaseGroup(uint32_t group);
+    void compactGroups();
+    void resetNextHops();
+    void sweepRegion(uint32_t regionStart, int regionLength,
+        std::vector<uint32_t>& starts, std::vector<uint32_t>& groups) const;
+    void rebuildRanges();
+    void spliceRanges(const std::vector<RangeSplice>& splices,
+        const std::vector<uint32_t>& starts, const std::vector<uint32_t>& groups);
+    void buildBuckets();
+    void attachOwnedStorage();
+    void copyImageToOwnedStorage();
+};
+
+#endif
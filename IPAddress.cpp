@@ -0,0 +1,57 @@
+#include "IPAddress.h"
+
+using namespace std;
+
+// Advances cursor past the address on success. Time Complexity: O(1)
+bool IPAddress::parse(const char*& cursor, const char* end, uint32_t& address) {
+    const char* p = cursor;
+    uint32_t result = 0;
+
+    for (int octet = 0; octet < 4; octet++) {
+        if (octet > 0) {
+            if (p == end || *p != '.') {
+                return false;
+            }
+            p++;
+        }
+
+        uint32_t value = 0;
+        int digits = 0;
+        while (p != end && *p >= '0' && *p <= '9' && digits < 3) {
+            value = value * 10 + static_cast<uint32_t>(*p - '0');
+            p++;
+            digits++;
+        }
+        if (digits == 0 || value > 255) {
+            return false;
+        }
+        result = (result << 8) | value;
+    }
+
+    address = result;
+    cursor = p;
+    return true;
+}
+
+bool IPAddress::parse(const string& text, uint32_t& address) {
+    const char* cursor = text.data();
+    const char* end = cursor + text.size();
+    return parse(cursor, end, address) && cursor == end;
+}
+
+string IPAddress::toString(uint32_t address) {
+    return to_string((address >> 24) & 0xFF) + "." +
+        to_string((address >> 16) & 0xFF) + "." +
+        to_string((address >> 8) & 0xFF) + "." +
+        to_string(address & 0xFF);
+}
+
+uint32_t IPAddress::prefixMask(int prefixLength) {
+    if (prefixLength <= 0) {
+        return 0;
+    }
+    if (prefixLength >= 32) {
+        return 0xFFFFFFFFu;
+    }
+    return 0xFFFFFFFFu << (32 - prefixLength);
+}
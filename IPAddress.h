@@ -0,0 +1,17 @@
+#ifndef IPADDRESS_H
+#define IPADDRESS_H
+
+#include <cstdint>
+#include <string>
+
+// Allocation-free dotted-quad helpers shared by the route and packet parsers.
+class IPAddress {
+public:
+    static bool parse(const char*& cursor, const char* end, uint32_t& address);
+    static bool parse(const std::string& text, uint32_t& address);
+    static std::string toString(uint32_t address);
+
+    static uint32_t prefixMask(int prefixLength);
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "Link.h"
+
+using namespace std;
+
+// bandwidth in bits per second, propagationDelay in nanoseconds
+Link::Link(double bandwidth, long long propagationDelay, pmr::memory_resource* resource)
+    : bandwidth(bandwidth), propagationDelay(propagationDelay), busy(false),
+    inFlight(pmr::polymorphic_allocator<packets>(resource)), packetsSent(0), bytesSent(0), busyTime(0) {
+}
+
+Link::Link(const Link& other, pmr::memory_resource* resource)
+    : bandwidth(other.bandwidth), propagationDelay(other.propagationDelay), busy(other.busy),
+    inFlight(other.inFlight, pmr::polymorphic_allocator<packets>(resource)), packetsSent(other.packetsSent),
+    bytesSent(other.bytesSent), busyTime(other.busyTime) {
+}
+
+long long Link::getTransmissionTime(int bytes) const {
+    return static_cast<long long>(bytes * 8.0 * 1e9 / bandwidth);
+}
+
+long long Link::getPropagationDelay() const {
+    return propagationDelay;
+}
+
+double Link::getBandwidth() const {
+    return bandwidth;
+}
+
+bool Link::isBusy() const {
+    return busy;
+}
+
+// Starts serializing the packet and returns how long that takes.
+long long Link::send(const packets& packet) {
+    long long duration = getTransmissionTime(packet.getSize());
+    busy = true;
+    inFlight.push(packet);
+    packetsSent++;
+    bytesSent += packet.getSize();
+    busyTime += duration;
+    return duration;
+}
+
+void Link::finishTransmission() {
+    busy = false;
+}
+
+// Removes the oldest packet on the wire.
+packets Link::receive() {
+    packets packet = inFlight.front();
+    inFlight.pop();
+    return packet;
+}
+
+long long Link::getPacketsSent() const {
+    return packetsSent;
+}
+
+long long Link::getBytesSent() const {
+    return bytesSent;
+}
+
+double Link::getUtilization(long long elapsed) const {
+    if (elapsed <= 0) {
+        return 0;
+    }
+    return static_cast<double>(busyTime) / elapsed;
+}
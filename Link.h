@@ -0,0 +1,45 @@
+#ifndef LINK_H
+#define LINK_H
+
+#include <deque>
+#include <memory_resource>
+#include <queue>
+#include "packets.h"
+
+// Point-to-point link with a serialization rate and a fixed propagation
+// delay. The sender owns the link while a packet is being serialized;
+// packets already on the wire are kept in order until they arrive, in
+// memory from the resource given at construction.
+class Link {
+private:
+    double bandwidth;
+    long long propagationDelay;
+    bool busy;
+    std::queue<packets, std::pmr::deque<packets>> inFlight;
+
+    long long packetsSent;
+    long long bytesSent;
+    long long busyTime;
+
+public:
+    Link(double bandwidth = 1e9, long long propagationDelay = 0,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    Link(const Link& other) = default;
+    Link(const Link& other, std::pmr::memory_resource* resource);
+    Link& operator=(const Link& other) = default;
+
+    long long getTransmissionTime(int bytes) const;
+    long long getPropagationDelay() const;
+    double getBandwidth() const;
+
+    bool isBusy() const;
+    long long send(const packets& packet);
+    void finishTransmission();
+    packets receive();
+
+    long long getPacketsSent() const;
+    long long getBytesSent() const;
+    double getUtilization(long long elapsed) const;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "LoadGenerator.h"
+#include "Clock.h"
+#include "PacketSocket.h"
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+LoadGenerator::LoadGenerator(const vector<packets>& templates)
+    : templates(templates), sentCount(0), sendErrors(0), receivedCount(0), sendTime(0), receiveTime(0) {
+}
+
+// Sends for duration, then keeps receiving for DRAIN_TIME. The egress
+// socket is bound before the first packet goes out, so nothing the router
+// forwards is missed. Packets the socket refuses count against the rate
+// like sent ones, so a full socket shows up as loss, not as a retry storm.
+bool LoadGenerator::run(const string& ingress, const string& egress, long long duration, double rate) {
+    if (templates.empty()) {
+        cout << "Error: No packets to send" << endl;
+        return false;
+    }
+
+    PacketSocket input;
+    PacketSocket output;
+    SocketPoller poller;
+    if (!input.bind(egress) || !output.connect(ingress) || !poller.add(input)) {
+        return false;
+    }
+
+    vector<packets> batch;
+    vector<packets> received;
+    vector<int> ready;
+    const vector<uint32_t> noHops;
+    batch.reserve(PacketSocket::MAX_BATCH);
+    received.reserve(PacketSocket::MAX_BATCH);
+    latencies.clear();
+    latencies.reserve(rate > 0 ? static_cast<size_t>(rate * duration / 1e9) + 1 : 1 << 20);
+
+    size_t next = 0;
+    long long start = Clock::now();
+    long long sendEnd = start + duration;
+    long long end = sendEnd + DRAIN_TIME;
+    long long firstReceive = 0;
+    long long lastReceive = 0;
+
+    for (long long now = start; now < end; now = Clock::now()) {
+        // Packets due by now at the target rate, at most one batch per turn
+        size_t due = 0;
+        if (now < sendEnd) {
+            due = PacketSocket::MAX_BATCH;
+            if (rate > 0) {
+                double target = rate * (now - start) / 1e9;
+                uint64_t offered = sentCount + sendErrors;
+                due = target > offered ? static_cast<size_t>(target - offered) : 0;
+                due = min(due, PacketSocket::MAX_BATCH);
+            }
+        }
+
+        if (due > 0) {
+            batch.clear();
+            for (size_t i = 0; i < due; i++) {
+                batch.push_back(templates[next]);
+                batch.back().setOriginTime(now);
+                next = next + 1 == templates.size() ? 0 : next + 1;
+            }
+            size_t sent = output.sendBatch(batch, noHops);
+            sentCount += sent;
+            sendErrors += due - sent;
+        }
+
+        int timeout = due > 0 || (rate <= 0 && now < sendEnd) ? 0 : 1;
+        if (poller.wait(timeout, ready) <= 0) {
+            continue;
+        }
+        while (true) {
+            received.clear();
+            if (input.receiveBatch(received) == 0) {
+                break;
+            }
+            long long arrival = Clock::now();
+            if (firstReceive == 0) {
+                firstReceive = arrival;
+            }
+            lastReceive = arrival;
+            for (const packets& packet : received) {
+                latencies.push_back(arrival - packet.getOriginTime());
+            }
+            receivedCount += received.size();
+        }
+    }
+
+    sendTime = duration;
+    receiveTime = lastReceive - firstReceive;
+    sort(latencies.begin(), latencies.end());
+    return true;
+}
+
+uint64_t LoadGenerator::getSentCount() const {
+    return sentCount;
+}
+
+uint64_t LoadGenerator::getReceivedCount() const {
+    return receivedCount;
+}
+
+// percentile in [0, 100]
+long long LoadGenerator::getLatencyPercentile(double percentile) const {
+    if (latencies.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(percentile / 100.0 * (latencies.size() - 1));
+    return latencies[index];
+}
+
+void LoadGenerator::displayResults() const {
+    cout << "\n--- Load Generator Results ---" << endl;
+    cout << "Sent: " << sentCount << " packets (" << (sendTime > 0 ? sentCount * 1e9 / sendTime : 0)
+        << " packets/s), " << sendErrors << " not accepted by the socket" << endl;
+    cout << "Received: " << receivedCount << " forwarded packets ("
+        << (receiveTime > 0 ? receivedCount * 1e9 / receiveTime : 0) << " packets/s), "
+        << (sentCount > receivedCount ? sentCount - receivedCount : 0) << " dropped or lost" << endl;
+    cout << "End-to-end latency: p50 " << getLatencyPercentile(50) / 1000.0 << "us, p99 "
+        << getLatencyPercentile(99) / 1000.0 << "us, p99.9 " << getLatencyPercentile(99.9) / 1000.0
+        << "us, max " << getLatencyPercentile(100) / 1000.0 << "us" << endl;
+}
@@ -0,0 +1,39 @@
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Packets.h"
+
+// Local traffic generator for a router serving sockets ("router --serve"),
+// meant to run as a separate process. Replays the template packets in a
+// loop at a fixed rate (0 = as fast as the socket takes them), stamping
+// each with its send time, and receives the router's egress to report
+// delivered packets per second and end-to-end latency percentiles.
+class LoadGenerator {
+public:
+    LoadGenerator(const std::vector<packets>& templates);
+
+    bool run(const std::string& ingress, const std::string& egress, long long duration, double rate);
+
+    uint64_t getSentCount() const;
+    uint64_t getReceivedCount() const;
+    long long getLatencyPercentile(double percentile) const;
+    void displayResults() const;
+
+private:
+    // Time allowed for packets still inside the router after sending stops
+    static const long long DRAIN_TIME = 200000000LL;
+
+    std::vector<packets> templates;
+    std::vector<long long> latencies;
+    uint64_t sentCount;
+    uint64_t sendErrors;
+    uint64_t receivedCount;
+    long long sendTime;
+    long long receiveTime;
+};
+
+#endif
@@ -0,0 +1,498 @@
+#include "NetworkSimulator.h"
+#include "Clock.h"
+#include "FlowTable.h"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+NetworkSimulator::PacketState::PacketState(const allocator_type& allocator)
+    : history(allocator), created(0) {
+}
+
+NetworkSimulator::PacketState::PacketState(const PacketState& other, const allocator_type& allocator)
+    : history(other.history, allocator), created(other.created) {
+}
+
+NetworkSimulator::Message::Message(const PacketState::allocator_type& allocator)
+    : time(0), router(0), state(allocator) {
+}
+
+NetworkSimulator::Partition::Partition()
+    : arena(&heap), pool(&arena), index(0), now(0), windowEnd(0), nextSequence(0), states(&pool),
+    eventCount(0), forwarded(0), warmupForwarded(0), warmupAllocations(0), warmedUp(false),
+    created(0), delivered(0), hops(0),
+    droppedTTL(0), droppedNoRoute(0), droppedQueue(0), droppedLoop(0) {
+    for (int qosClass = 0; qosClass < 3; qosClass++) {
+        classLatency[qosClass] = 0;
+        classDelivered[qosClass] = 0;
+    }
+}
+
+NetworkSimulator::NetworkSimulator(Topology* topology, int threadCount)
+    : topology(topology), threadCount(threadCount), lookahead(NO_EVENT), endTime(0), warmupTime(0), wallTime(0),
+    windowCount(0), barrierWaiting(0), barrierGeneration(0) {
+}
+
+NetworkSimulator::~NetworkSimulator() {
+    for (Partition* partition : partitions) {
+        delete partition;
+    }
+}
+
+// Generation barrier: the last thread to arrive releases the others.
+void NetworkSimulator::waitAtBarrier() {
+    unique_lock<mutex> lock(barrierMutex);
+    long long generation = barrierGeneration;
+    if (++barrierWaiting == threadCount) {
+        barrierWaiting = 0;
+        barrierGeneration++;
+        barrierCondition.notify_all();
+        return;
+    }
+    barrierCondition.wait(lock, [&] { return barrierGeneration != generation; });
+}
+
+// Runs for duration nanoseconds of virtual time, then lets packets already
+// queued or on the wire drain.
+void NetworkSimulator::run(long long duration) {
+    size_t routerCount = topology->getRouterCount();
+    if (routerCount == 0) {
+        return;
+    }
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+    if (static_cast<size_t>(threadCount) > routerCount) {
+        threadCount = static_cast<int>(routerCount);
+    }
+
+    for (Partition* partition : partitions) {
+        delete partition;
+    }
+    partitions.clear();
+    for (int i = 0; i < threadCount; i++) {
+        Partition* partition = new Partition();
+        partition->index = static_cast<uint32_t>(i);
+        partition->outbox.resize(threadCount);
+        partitions.push_back(partition);
+    }
+    nextTimes.assign(threadCount, static_cast<long long>(NO_EVENT));
+    endTime = duration;
+    warmupTime = duration / 2;
+    windowCount = 0;
+
+    owner.resize(routerCount);
+    for (size_t router = 0; router < routerCount; router++) {
+        owner[router] = static_cast<uint32_t>(router * threadCount / routerCount);
+        topology->setMemoryResource(static_cast<uint32_t>(router), &partitions[owner[router]]->pool);
+        const Topology::Router& entry = topology->getRouter(static_cast<uint32_t>(router));
+        for (uint32_t source = 0; source < entry.sources.size(); source++) {
+            SourceRef ref;
+            ref.router = static_cast<uint32_t>(router);
+            ref.source = source;
+            partitions[owner[router]]->sources.push_back(ref);
+        }
+    }
+
+    // Links between blocks with no propagation delay still get 1ns, which
+    // delays packets on them by up to one window
+    lookahead = NO_EVENT;
+    for (uint32_t port = 0; port < topology->getPortCount(); port++) {
+        const Topology::Port& entry = topology->getPort(port);
+        if (owner[entry.router] != owner[entry.neighbor]) {
+            long long delay = max(1LL, entry.link.getPropagationDelay());
+            if (delay < lookahead) {
+                lookahead = delay;
+            }
+        }
+    }
+
+    long long wallStart = Clock::now();
+    if (threadCount == 1) {
+        runPartition(*partitions[0]);
+    }
+    else {
+        vector<thread> workers;
+        for (Partition* partition : partitions) {
+            workers.emplace_back(&NetworkSimulator::runPartition, this, ref(*partition));
+        }
+        for (thread& worker : workers) {
+            worker.join();
+        }
+    }
+    wallTime += Clock::now() - wallStart;
+
+    // The pools go away with the simulator; the topology outlives it
+    for (uint32_t router = 0; router < routerCount; router++) {
+        topology->setMemoryResource(router, pmr::get_default_resource());
+    }
+}
+
+// Each window: exchange mailboxes, agree on the earliest pending event,
+// free the messages this block sent, then run every local event before
+// that time plus the lookahead.
+void NetworkSimulator::runPartition(Partition& partition) {
+    for (uint32_t i = 0; i < partition.sources.size(); i++) {
+        const SourceRef& ref = partition.sources[i];
+        long long first = topology->getRouter(ref.router).sources[ref.source].nextArrival(0);
+        if (first < endTime) {
+            schedule(partition, first, SOURCE_ARRIVAL, i);
+        }
+    }
+
+    while (true) {
+        waitAtBarrier();
+        drainMailboxes(partition);
+        nextTimes[partition.index] = partition.events.empty() ? NO_EVENT : partition.events.peekTime();
+        waitAtBarrier();
+        for (vector<Message>& mailbox : partition.outbox) {
+            mailbox.clear();
+        }
+
+        long long windowStart = *min_element(nextTimes.begin(), nextTimes.end());
+        if (windowStart == NO_EVENT) {
+            return;
+        }
+        partition.windowEnd = (lookahead >= NO_EVENT - windowStart) ? NO_EVENT : windowStart + lookahead;
+        if (partition.index == 0) {
+            windowCount++;
+        }
+
+        while (!partition.events.empty() && partition.events.peekTime() < partition.windowEnd) {
+            SimEvent event = partition.events.pop();
+            partition.now = event.time;
+            partition.eventCount++;
+            if (!partition.warmedUp && partition.now >= warmupTime) {
+                partition.warmedUp = true;
+                partition.warmupForwarded = partition.forwarded;
+                partition.warmupAllocations = partition.heap.getAllocationCount();
+            }
+
+            if (event.type == SOURCE_ARRIVAL) {
+                handleSourceArrival(partition, event.target);
+            }
+            else if (event.type == PACKET_RECEIVED) {
+                Transit& transit = partition.transit[event.target];
+                packets packet = transit.packet;
+                uint32_t router = transit.router;
+                partition.freeTransit.push_back(event.target);
+                receivePacket(partition, router, packet);
+            }
+            else {
+                handleTransmitComplete(partition, event.target);
+            }
+        }
+    }
+}
+
+// Copies the state into this block's pool; the sender clears its outbox
+// after the next barrier, in its own thread.
+void NetworkSimulator::drainMailboxes(Partition& partition) {
+    for (Partition* sender : partitions) {
+        const vector<Message>& mailbox = sender->outbox[partition.index];
+        for (const Message& message : mailbox) {
+            partition.states.emplace(message.packet.getId(), message.state);
+            scheduleReceive(partition, message.time, message.router, message.packet);
+        }
+    }
+}
+
+void NetworkSimulator::schedule(Partition& partition, long long time, uint32_t type, uint32_t target) {
+    SimEvent event;
+    event.time = time;
+    event.type = type;
+    event.target = target;
+    partition.events.push(event);
+}
+
+void NetworkSimulator::scheduleReceive(Partition& partition, long long time, uint32_t router, const packets& packet) {
+    uint32_t slot = 0;
+    if (partition.freeTransit.empty()) {
+        slot = static_cast<uint32_t>(partition.transit.size());
+        partition.transit.emplace_back();
+    }
+    else {
+        slot = partition.freeTransit.back();
+        partition.freeTransit.pop_back();
+    }
+    partition.transit[slot].packet = packet;
+    partition.transit[slot].router = router;
+    schedule(partition, time, PACKET_RECEIVED, slot);
+}
+
+// Packet ids are interleaved across blocks so they stay unique.
+void NetworkSimulator::handleSourceArrival(Partition& partition, uint32_t sourceRef) {
+    const SourceRef& ref = partition.sources[sourceRef];
+    TrafficSource& source = topology->getRouter(ref.router).sources[ref.source];
+
+    int id = static_cast<int>(partition.index) + 1 + threadCount * partition.nextSequence++;
+    packets packet = source.makePacket(id);
+    PacketState& state = partition.states[id];
+    state.history = PacketHistory(id);
+    state.created = partition.now;
+    partition.created++;
+    receivePacket(partition, ref.router, packet);
+
+    long long next = source.nextArrival(partition.now);
+    if (next < endTime) {
+        schedule(partition, next, SOURCE_ARRIVAL, sourceRef);
+    }
+}
+
+// The loop check is PacketHistory::detectLoop without its console report,
+// since worker threads would interleave their output.
+void NetworkSimulator::receivePacket(Partition& partition, uint32_t routerIndex, packets& packet) {
+    Topology::Router& router = topology->getRouter(routerIndex);
+    PacketState& state = partition.states[packet.getId()];
+
+    if (state.history.hasVisitedRouter(router.name)) {
+        partition.droppedLoop++;
+        recordTrace(partition, state, router.name, "DROPPED_LOOP", 0, packet.getTTL());
+        if (partition.loopSamples.size() < SAMPLE_HISTORIES) {
+            partition.loopSamples.push_back(state.history);
+        }
+        finishPacket(partition, packet, false);
+        return;
+    }
+
+    packet.decrementTTL();
+    if (packet.getTTL() <= 0) {
+        partition.droppedTTL++;
+        recordTrace(partition, state, router.name, "DROPPED_TTL", 0, packet.getTTL());
+        finishPacket(partition, packet, false);
+        return;
+    }
+
+    uint32_t port = Topology::NO_PORT;
+    uint32_t group = router.forwardingTable.lookup(packet.getDestinationAddress());
+    if (group != ForwardingTable::NO_ROUTE) {
+        uint32_t flowHash = FlowTable::flowHash(packet.getSourceAddress(), packet.getDestinationAddress(),
+            static_cast<uint16_t>(packet.getPort()));
+        uint32_t hop = router.forwardingTable.recordForward(router.forwardingTable.selectMember(group, flowHash));
+        port = router.hopPorts[hop];
+    }
+
+    if (port == Topology::NO_PORT) {
+        partition.droppedNoRoute++;
+        recordTrace(partition, state, router.name, "DROPPED_NO_ROUTE", 0, packet.getTTL());
+        finishPacket(partition, packet, false);
+        return;
+    }
+    if (port == Topology::LOCAL_PORT) {
+        recordTrace(partition, state, router.name, "DELIVERED", 0, packet.getTTL());
+        finishPacket(partition, packet, true);
+        return;
+    }
+
+    Topology::Port& egress = topology->getPort(port);
+    if (!egress.qos.enqueuePacket(packet, partition.now)) {
+        partition.droppedQueue++;
+        recordTrace(partition, state, router.name, "DROPPED_QUEUE", 0, packet.getTTL());
+        finishPacket(partition, packet, false);
+        return;
+    }
+    if (!egress.link.isBusy()) {
+        startTransmission(partition, port);
+    }
+}
+
+// The FORWARDED trace is recorded when the packet leaves the queue, so it
+// carries the packet's queueing delay at this hop.
+void NetworkSimulator::startTransmission(Partition& partition, uint32_t port) {
+    Topology::Port& egress = topology->getPort(port);
+    if (egress.qos.allQueuesEmpty()) {
+        return;
+    }
+
+    packets packet = egress.qos.getNextPacket(partition.now);
+    recordTrace(partition, partition.states[packet.getId()], topology->getRouter(egress.router).name,
+        "FORWARDED", packet.getQueueDelay(), packet.getTTL(), topology->getRouter(egress.neighbor).name);
+    partition.forwarded++;
+    schedule(partition, partition.now + egress.link.send(packet), TRANSMIT_COMPLETE, port);
+}
+
+void NetworkSimulator::handleTransmitComplete(Partition& partition, uint32_t port) {
+    Topology::Port& egress = topology->getPort(port);
+    egress.link.finishTransmission();
+    packets packet = egress.link.receive();
+    long long arrival = partition.now + egress.link.getPropagationDelay();
+
+    uint32_t receiver = owner[egress.neighbor];
+    if (receiver == partition.index) {
+        scheduleReceive(partition, arrival, egress.neighbor, packet);
+    }
+    else {
+        auto state = partition.states.find(packet.getId());
+        Message message(&partition.pool);
+        message.time = max(arrival, partition.windowEnd);
+        message.router = egress.neighbor;
+        message.packet = packet;
+        message.state = move(state->second);
+        partition.states.erase(state);
+        partition.outbox[receiver].push_back(move(message));
+    }
+
+    startTransmission(partition, port);
+}
+
+void NetworkSimulator::recordTrace(Partition& partition, PacketState& state, const string& routerID,
+    const string& action, long long queueDelay, int ttl, const string& nextHop) {
+    TraceEntry entry(routerID, action, queueDelay, ttl, nextHop);
+    entry.setTimestamp(partition.now);
+    state.history.addTrace(entry);
+}
+
+// End-to-end latency: creation at the source router to delivery.
+void NetworkSimulator::finishPacket(Partition& partition, const packets& packet, bool delivered) {
+    auto state = partition.states.find(packet.getId());
+    if (delivered) {
+        partition.delivered++;
+        partition.hops += static_cast<long long>(state->second.history.getHopCount()) - 1;
+        int qosClass = packet.getQosClass();
+        if (qosClass >= 0) {
+            partition.classLatency[qosClass] += partition.now - state->second.created;
+            partition.classDelivered[qosClass]++;
+        }
+        if (partition.deliveredSamples.size() < SAMPLE_HISTORIES) {
+            partition.deliveredSamples.push_back(state->second.history);
+        }
+    }
+    partition.states.erase(state);
+}
+
+long long NetworkSimulator::getEventCount() const {
+    long long total = 0;
+    for (const Partition* partition : partitions) {
+        total += partition->eventCount;
+    }
+    return total;
+}
+
+long long NetworkSimulator::getCreatedCount() const {
+    long long total = 0;
+    for (const Partition* partition : partitions) {
+        total += partition->created;
+    }
+    return total;
+}
+
+long long NetworkSimulator::getDeliveredCount() const {
+    long long total = 0;
+    for (const Partition* partition : partitions) {
+        total += partition->delivered;
+    }
+    return total;
+}
+
+long long NetworkSimulator::getDroppedCount() const {
+    long long total = 0;
+    for (const Partition* partition : partitions) {
+        total += partition->droppedTTL + partition->droppedNoRoute + partition->droppedQueue + partition->droppedLoop;
+    }
+    return total;
+}
+
+long long NetworkSimulator::getWallTime() const {
+    return wallTime;
+}
+
+// Heap allocations made by the block pools after the warm-up (the first
+// half of the simulated time).
+long long NetworkSimulator::getSteadyStateAllocations() const {
+    long long total = 0;
+    for (const Partition* partition : partitions) {
+        if (partition->warmedUp) {
+            total += partition->heap.getAllocationCount() - partition->warmupAllocations;
+        }
+    }
+    return total;
+}
+
+long long NetworkSimulator::getSteadyStateForwarded() const {
+    long long total = 0;
+    for (const Partition* partition : partitions) {
+        if (partition->warmedUp) {
+            total += partition->forwarded - partition->warmupForwarded;
+        }
+    }
+    return total;
+}
+
+void NetworkSimulator::displayResults() const {
+    const char* names[] = { "High", "Medium", "Low" };
+    long long hops = 0;
+    long long droppedTTL = 0;
+    long long droppedNoRoute = 0;
+    long long droppedQueue = 0;
+    long long droppedLoop = 0;
+    long long classLatency[3] = { 0, 0, 0 };
+    long long classDelivered[3] = { 0, 0, 0 };
+    for (const Partition* partition : partitions) {
+        hops += partition->hops;
+        droppedTTL += partition->droppedTTL;
+        droppedNoRoute += partition->droppedNoRoute;
+        droppedQueue += partition->droppedQueue;
+        droppedLoop += partition->droppedLoop;
+        for (int qosClass = 0; qosClass < 3; qosClass++) {
+            classLatency[qosClass] += partition->classLatency[qosClass];
+            classDelivered[qosClass] += partition->classDelivered[qosClass];
+        }
+    }
+
+    long long events = getEventCount();
+    long long delivered = getDeliveredCount();
+    cout << "\n--- Network Simulation Results ---" << endl;
+    cout << "Threads: " << threadCount << " | Windows: " << windowCount;
+    if (lookahead != NO_EVENT) {
+        cout << " | Lookahead: " << lookahead / 1000.0 << "us";
+    }
+    cout << endl;
+    cout << "Events: " << events << " (" << (wallTime > 0 ? events * 1e9 / wallTime : 0) << " events/s, "
+        << Clock::toMilliseconds(wallTime) << "ms wall)" << endl;
+    cout << "Packets: " << getCreatedCount() << " created, " << delivered << " delivered, "
+        << droppedTTL << " dropped (TTL), " << droppedNoRoute << " dropped (no route), "
+        << droppedQueue << " dropped (queue), " << droppedLoop << " dropped (loop)" << endl;
+    if (delivered > 0) {
+        cout << "Average Path: " << static_cast<double>(hops) / delivered << " hops per delivered packet" << endl;
+    }
+
+    long long allocations = 0;
+    size_t peakBytes = 0;
+    for (const Partition* partition : partitions) {
+        allocations += partition->heap.getAllocationCount();
+        peakBytes += partition->heap.getPeakBytesInUse();
+    }
+    long long steadyForwarded = getSteadyStateForwarded();
+    cout << "Memory: " << allocations << " heap allocations by " << threadCount << " block pools ("
+        << peakBytes / 1024 << "KB), " << getSteadyStateAllocations() << " after warm-up";
+    if (steadyForwarded > 0) {
+        cout << " (" << static_cast<double>(getSteadyStateAllocations()) / steadyForwarded
+            << " per forwarded packet)";
+    }
+    cout << endl;
+
+    cout << "End-to-End Latency by Class:" << endl;
+    for (int qosClass = 0; qosClass < 3; qosClass++) {
+        long long average = classDelivered[qosClass] == 0 ? 0 : classLatency[qosClass] / classDelivered[qosClass];
+        cout << "  " << names[qosClass] << ": delivered " << classDelivered[qosClass]
+            << ", avg " << Clock::toMilliseconds(average) << "ms" << endl;
+    }
+
+    cout << "Sample Paths:" << endl;
+    size_t shown = 0;
+    for (const Partition* partition : partitions) {
+        for (size_t i = 0; i < partition->deliveredSamples.size() && shown < SAMPLE_HISTORIES; i++, shown++) {
+            cout << "  ";
+            partition->deliveredSamples[i].displayCompactHistory();
+        }
+    }
+    shown = 0;
+    for (const Partition* partition : partitions) {
+        for (size_t i = 0; i < partition->loopSamples.size() && shown < SAMPLE_HISTORIES; i++, shown++) {
+            cout << "  ";
+            partition->loopSamples[i].displayCompactHistory();
+        }
+    }
+}
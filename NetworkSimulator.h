@@ -0,0 +1,165 @@
+#ifndef NETWORKSIMULATOR_H
+#define NETWORKSIMULATOR_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AllocationCounter.h"
+#include "PoolResource.h"
+#include "EventQueue.h"
+#include "PacketHistory.h"
+#include "Topology.h"
+
+// Discrete-event simulation of a whole Topology, forwarding packets hop by
+// hop through each router's FIB and egress QoService and recording a
+// PacketHistory per packet; a packet that comes back to a router it already
+// visited is dropped as a loop.
+//
+// Routers are split into contiguous blocks, one per thread, each block with
+// its own event queue. Packets crossing blocks are posted to the receiving
+// block's mailbox. Threads advance in lockstep windows as long as the
+// smallest propagation delay between blocks (the lookahead): nothing sent
+// during a window can arrive before it ends, so a block never receives a
+// packet in its past, and apart from the order of simultaneous events the
+// results do not depend on the thread count.
+//
+// Each block allocates packet state, histories and its routers' queues from
+// its own pool resource, so threads never share an allocator. The pool sits
+// on a monotonic arena over an AllocationCounter; once the pool has grown
+// to the working set the heap count stops moving, which displayResults()
+// reports for the second half of the run.
+class NetworkSimulator {
+public:
+    enum EventType { SOURCE_ARRIVAL, PACKET_RECEIVED, TRANSMIT_COMPLETE };
+
+    NetworkSimulator(Topology* topology, int threadCount = 1);
+    ~NetworkSimulator();
+
+    NetworkSimulator(const NetworkSimulator&) = delete;
+    NetworkSimulator& operator=(const NetworkSimulator&) = delete;
+
+    void run(long long duration);
+
+    long long getEventCount() const;
+    long long getCreatedCount() const;
+    long long getDeliveredCount() const;
+    long long getDroppedCount() const;
+    long long getWallTime() const;
+    long long getSteadyStateAllocations() const;
+    long long getSteadyStateForwarded() const;
+    void displayResults() const;
+
+private:
+    static const long long NO_EVENT = 0x7FFFFFFFFFFFFFFFLL;
+    static const size_t SAMPLE_HISTORIES = 3;
+
+    struct PacketState {
+        typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
+        PacketHistory history;
+        long long created;
+
+        explicit PacketState(const allocator_type& allocator = allocator_type());
+        PacketState(const PacketState& other) = default;
+        PacketState(PacketState&& other) = default;
+        PacketState(const PacketState& other, const allocator_type& allocator);
+        PacketState& operator=(const PacketState& other) = default;
+        PacketState& operator=(PacketState&& other) = default;
+    };
+
+    // A packet on its way into a router of the same block
+    struct Transit {
+        packets packet;
+        uint32_t router;
+    };
+
+    // A packet on its way into a router of another block. The state stays
+    // in the sender's pool; the receiver copies it out and the sender frees
+    // it once the exchange is over.
+    struct Message {
+        long long time;
+        uint32_t router;
+        packets packet;
+        PacketState state;
+
+        explicit Message(const PacketState::allocator_type& allocator);
+    };
+
+    struct SourceRef {
+        uint32_t router;
+        uint32_t source;
+    };
+
+    struct Partition {
+        AllocationCounter heap;
+        std::pmr::monotonic_buffer_resource arena;
+        PoolResource pool;
+
+        uint32_t index;
+        EventQueue events;
+        long long now;
+        long long windowEnd;
+        int nextSequence;
+
+        std::vector<SourceRef> sources;
+        std::pmr::unordered_map<int, PacketState> states;
+        std::vector<Transit> transit;
+        std::vector<uint32_t> freeTransit;
+        std::vector<std::vector<Message>> outbox;    // indexed by receiving block
+
+        long long eventCount;
+        long long forwarded;
+        long long warmupForwarded;
+        long long warmupAllocations;
+        bool warmedUp;
+        long long created;
+        long long delivered;
+        long long hops;
+        long long droppedTTL;
+        long long droppedNoRoute;
+        long long droppedQueue;
+        long long droppedLoop;
+        long long classLatency[3];
+        long long classDelivered[3];
+        std::vector<PacketHistory> deliveredSamples;
+        std::vector<PacketHistory> loopSamples;
+
+        Partition();
+    };
+
+    Topology* topology;
+    int threadCount;
+    std::vector<uint32_t> owner;
+    std::vector<Partition*> partitions;
+    std::vector<long long> nextTimes;
+    long long lookahead;
+    long long endTime;
+    long long warmupTime;
+    long long wallTime;
+    long long windowCount;
+
+    std::mutex barrierMutex;
+    std::condition_variable barrierCondition;
+    int barrierWaiting;
+    long long barrierGeneration;
+
+    void waitAtBarrier();
+    void runPartition(Partition& partition);
+    void drainMailboxes(Partition& partition);
+
+    void schedule(Partition& partition, long long time, uint32_t type, uint32_t target);
+    void scheduleReceive(Partition& partition, long long time, uint32_t router, const packets& packet);
+    void handleSourceArrival(Partition& partition, uint32_t sourceRef);
+    void receivePacket(Partition& partition, uint32_t router, packets& packet);
+    void startTransmission(Partition& partition, uint32_t port);
+    void handleTransmitComplete(Partition& partition, uint32_t port);
+    void recordTrace(Partition& partition, PacketState& state, const std::string& routerID,
+        const std::string& action, long long queueDelay, int ttl, const std::string& nextHop = "");
+    void finishPacket(Partition& partition, const packets& packet, bool delivered);
+};
+
+#endif
@@ -0,0 +1,376 @@
+#include "PacketClassifier.h"
+#include "IPAddress.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+using namespace std;
+
+namespace {
+    // Same order as QoService::QosClass
+    const char* const CLASS_NAMES[] = { "High", "Medium", "Low" };
+    const int CLASS_COUNT = 3;
+
+    void skipSpaces(const char*& cursor, const char* end) {
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t')) {
+            cursor++;
+        }
+    }
+
+    bool parseNumber(const char*& cursor, const char* end, int& value) {
+        const char* start = cursor;
+        value = 0;
+        while (cursor < end && *cursor >= '0' && *cursor <= '9' && value <= 65535) {
+            value = value * 10 + (*cursor - '0');
+            cursor++;
+        }
+        return cursor > start;
+    }
+
+    // "a.b.c.d/len" or "*"
+    bool parsePrefix(const char*& cursor, const char* end, uint32_t& prefix, int& length) {
+        if (cursor < end && *cursor == '*') {
+            cursor++;
+            prefix = 0;
+            length = 0;
+            return true;
+        }
+        if (!IPAddress::parse(cursor, end, prefix) || cursor == end || *cursor != '/') {
+            return false;
+        }
+        cursor++;
+        if (!parseNumber(cursor, end, length) || length > 32) {
+            return false;
+        }
+        prefix &= IPAddress::prefixMask(length);
+        return true;
+    }
+
+    // "port", "low-high" or "*"
+    bool parsePorts(const char*& cursor, const char* end, int& low, int& high) {
+        if (cursor < end && *cursor == '*') {
+            cursor++;
+            low = 0;
+            high = 65535;
+            return true;
+        }
+        if (!parseNumber(cursor, end, low)) {
+            return false;
+        }
+        high = low;
+        if (cursor < end && *cursor == '-') {
+            cursor++;
+            if (!parseNumber(cursor, end, high)) {
+                return false;
+            }
+        }
+        return low <= high && high <= 65535;
+    }
+
+    int parseClass(const char*& cursor, const char* end) {
+        const char* start = cursor;
+        while (cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r' && *cursor != '#') {
+            cursor++;
+        }
+        string name(start, cursor);
+        for (int qosClass = 0; qosClass < CLASS_COUNT; qosClass++) {
+            if (name == CLASS_NAMES[qosClass]) {
+                return qosClass;
+            }
+        }
+        return PacketClassifier::NO_MATCH;
+    }
+}
+
+PacketClassifier::PacketClassifier() : entryCount(0) {
+}
+
+// Rule file format, one rule per line, first match wins:
+//   <source>/<len> <destination>/<len> <port>[-<port>] <High|Medium|Low>
+// "*" matches any prefix or port; "#" starts a comment.
+size_t PacketClassifier::loadFromFile(const string& filename) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        cout << "Error: Cannot open rule file " << filename << endl;
+        return 0;
+    }
+
+    const char* p = file.getData();
+    const char* end = p + file.getSize();
+    size_t loaded = 0;
+    size_t lineNumber = 0;
+
+    while (p < end) {
+        const char* lineEnd = p;
+        while (lineEnd < end && *lineEnd != '\n') {
+            lineEnd++;
+        }
+        lineNumber++;
+
+        const char* cursor = p;
+        p = lineEnd + 1;
+
+        skipSpaces(cursor, lineEnd);
+        if (cursor == lineEnd || *cursor == '#' || *cursor == '\r') {
+            continue;
+        }
+
+        ClassifierRule rule;
+        bool valid = parsePrefix(cursor, lineEnd, rule.source, rule.sourceLength);
+        skipSpaces(cursor, lineEnd);
+        valid = valid && parsePrefix(cursor, lineEnd, rule.destination, rule.destinationLength);
+        skipSpaces(cursor, lineEnd);
+        valid = valid && parsePorts(cursor, lineEnd, rule.portLow, rule.portHigh);
+        skipSpaces(cursor, lineEnd);
+        rule.qosClass = valid ? parseClass(cursor, lineEnd) : NO_MATCH;
+
+        if (rule.qosClass == NO_MATCH) {
+            cout << "Warning: Skipping malformed rule at line " << lineNumber << endl;
+            continue;
+        }
+        addRule(rule);
+        loaded++;
+    }
+
+    cout << "Loaded " << loaded << " classifier rules from " << filename << endl;
+    return loaded;
+}
+
+// Rules take effect at the next build().
+void PacketClassifier::addRule(const ClassifierRule& rule) {
+    rules.push_back(rule);
+    rules.back().source &= IPAddress::prefixMask(rule.sourceLength);
+    rules.back().destination &= IPAddress::prefixMask(rule.destinationLength);
+}
+
+void PacketClassifier::clear() {
+    rules.clear();
+    tuples.clear();
+    entries.clear();
+    candidates.clear();
+    filters.clear();
+    entryCount = 0;
+}
+
+uint32_t PacketClassifier::hashKey(uint32_t source, uint32_t destination, uint32_t port) {
+    uint32_t hash = source * 0x9E3779B1u ^ destination * 0x85EBCA77u ^ port * 0xC2B2AE3Du;
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+// Compiles the rules into per-tuple hash tables.
+// Time Complexity: O(r log r)
+void PacketClassifier::build() {
+    map<uint32_t, size_t> tupleIndex;
+    vector<vector<TupleEntry> > pending;
+    tuples.clear();
+    candidates.clear();
+    filters.clear();
+
+    for (uint32_t ruleIndex = 0; ruleIndex < rules.size(); ruleIndex++) {
+        const ClassifierRule& rule = rules[ruleIndex];
+        bool exactPort = rule.portLow == rule.portHigh;
+
+        uint32_t key = (static_cast<uint32_t>(rule.sourceLength) << 16) |
+            (static_cast<uint32_t>(rule.destinationLength) << 8) | (exactPort ? 1u : 0u);
+        auto found = tupleIndex.find(key);
+        if (found == tupleIndex.end()) {
+            Tuple tuple;
+            tuple.sourceMask = IPAddress::prefixMask(rule.sourceLength);
+            tuple.destinationMask = IPAddress::prefixMask(rule.destinationLength);
+            tuple.exactPort = exactPort;
+            tuple.firstRule = ruleIndex;
+            tuple.tableMask = 0;
+            tuple.filterMask = 0;
+            tuple.offset = 0;
+            tuple.filterOffset = 0;
+            found = tupleIndex.insert(make_pair(key, tuples.size())).first;
+            tuples.push_back(tuple);
+            pending.push_back(vector<TupleEntry>());
+        }
+
+        TupleEntry entry;
+        entry.source = rule.source;
+        entry.destination = rule.destination;
+        entry.port = exactPort ? static_cast<uint32_t>(rule.portLow) : 0;
+        entry.rule = ruleIndex;
+        pending[found->second].push_back(entry);
+    }
+
+    // Lay the tables out back to back, best tuple first
+    vector<size_t> order(tuples.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return tuples[a].firstRule < tuples[b].firstRule;
+    });
+
+    vector<Tuple> sorted;
+    sorted.reserve(tuples.size());
+    size_t totalSlots = 0;
+    size_t totalFilterWords = 0;
+    for (size_t i : order) {
+        Tuple tuple = tuples[i];
+        size_t slots = 4;
+        while (slots < pending[i].size() * 2) {
+            slots *= 2;
+        }
+        size_t filterBits = 64;
+        while (filterBits < pending[i].size() * 8) {
+            filterBits *= 2;
+        }
+        tuple.tableMask = static_cast<uint32_t>(slots - 1);
+        tuple.offset = totalSlots;
+        tuple.filterMask = static_cast<uint32_t>(filterBits - 1);
+        tuple.filterOffset = totalFilterWords;
+        totalSlots += slots;
+        totalFilterWords += filterBits / 64;
+        sorted.push_back(tuple);
+    }
+    tuples.swap(sorted);
+    filters.assign(totalFilterWords, 0);
+
+    TupleEntry empty;
+    empty.source = 0;
+    empty.destination = 0;
+    empty.port = 0;
+    empty.rule = NO_RULE;
+    entries.assign(totalSlots, empty);
+    entryCount = 0;
+
+    PortCandidate endOfRun;
+    endOfRun.portLow = 1;
+    endOfRun.portHigh = 0;
+    endOfRun.rule = NO_RULE;
+
+    for (size_t t = 0; t < tuples.size(); t++) {
+        const Tuple& tuple = tuples[t];
+        TupleEntry* table = &entries[tuple.offset];
+        vector<TupleEntry>& keys = pending[order[t]];
+
+        // Range tuples: group rules sharing a key into one run, kept in rule order
+        if (!tuple.exactPort) {
+            stable_sort(keys.begin(), keys.end(), [](const TupleEntry& a, const TupleEntry& b) {
+                return a.source != b.source ? a.source < b.source : a.destination < b.destination;
+            });
+        }
+
+        for (size_t k = 0; k < keys.size(); k++) {
+            const TupleEntry& entry = keys[k];
+            uint32_t hash = hashKey(entry.source, entry.destination, entry.port);
+            uint32_t filterBit = (hash >> 7) & tuple.filterMask;
+            filters[tuple.filterOffset + filterBit / 64] |= 1ull << (filterBit % 64);
+
+            uint32_t slot = hash & tuple.tableMask;
+            while (table[slot].rule != NO_RULE &&
+                !(table[slot].source == entry.source && table[slot].destination == entry.destination &&
+                    table[slot].port == entry.port)) {
+                slot = (slot + 1) & tuple.tableMask;
+            }
+
+            if (tuple.exactPort) {
+                // An identical key from an earlier rule shadows this one
+                if (table[slot].rule == NO_RULE) {
+                    table[slot] = entry;
+                    entryCount++;
+                }
+                continue;
+            }
+
+            table[slot] = entry;
+            table[slot].rule = static_cast<uint32_t>(candidates.size());
+            entryCount++;
+            while (k < keys.size() && keys[k].source == entry.source && keys[k].destination == entry.destination) {
+                const ClassifierRule& rule = rules[keys[k].rule];
+                PortCandidate candidate;
+                candidate.portLow = rule.portLow;
+                candidate.portHigh = rule.portHigh;
+                candidate.rule = keys[k].rule;
+                candidates.push_back(candidate);
+                k++;
+            }
+            candidates.push_back(endOfRun);
+            k--;
+        }
+    }
+}
+
+// Returns the class of the first matching rule, or NO_MATCH.
+// Time Complexity: O(t) - One hash probe per tuple, t = tuples, independent of rule count
+int PacketClassifier::classify(uint32_t source, uint32_t destination, int port) const {
+    uint32_t best = NO_RULE;
+    uint32_t portKey = static_cast<uint32_t>(port);
+
+    for (const Tuple& tuple : tuples) {
+        if (tuple.firstRule >= best) {
+            break;
+        }
+        uint32_t maskedSource = source & tuple.sourceMask;
+        uint32_t maskedDestination = destination & tuple.destinationMask;
+        uint32_t maskedPort = tuple.exactPort ? portKey : 0;
+
+        uint32_t hash = hashKey(maskedSource, maskedDestination, maskedPort);
+        uint32_t filterBit = (hash >> 7) & tuple.filterMask;
+        if ((filters[tuple.filterOffset + filterBit / 64] & (1ull << (filterBit % 64))) == 0) {
+            continue;
+        }
+
+        const TupleEntry* table = &entries[tuple.offset];
+        uint32_t slot = hash & tuple.tableMask;
+        while (table[slot].rule != NO_RULE) {
+            if (table[slot].source == maskedSource && table[slot].destination == maskedDestination &&
+                table[slot].port == maskedPort) {
+                if (tuple.exactPort) {
+                    best = min(best, table[slot].rule);
+                    break;
+                }
+                for (const PortCandidate* candidate = &candidates[table[slot].rule];
+                    candidate->rule < best; candidate++) {
+                    if (port >= candidate->portLow && port <= candidate->portHigh) {
+                        best = candidate->rule;
+                        break;
+                    }
+                }
+                break;
+            }
+            slot = (slot + 1) & tuple.tableMask;
+        }
+    }
+
+    return best == NO_RULE ? NO_MATCH : rules[best].qosClass;
+}
+
+// Reference first-match scan over the rule list.
+// Time Complexity: O(r)
+int PacketClassifier::classifyLinear(uint32_t source, uint32_t destination, int port) const {
+    for (const ClassifierRule& rule : rules) {
+        uint32_t sourceMask = IPAddress::prefixMask(rule.sourceLength);
+        uint32_t destinationMask = IPAddress::prefixMask(rule.destinationLength);
+        if ((source & sourceMask) == rule.source && (destination & destinationMask) == rule.destination &&
+            port >= rule.portLow && port <= rule.portHigh) {
+            return rule.qosClass;
+        }
+    }
+    return NO_MATCH;
+}
+
+size_t PacketClassifier::getRuleCount() const {
+    return rules.size();
+}
+
+size_t PacketClassifier::getTupleCount() const {
+    return tuples.size();
+}
+
+size_t PacketClassifier::getEntryCount() const {
+    return entryCount;
+}
+
+void PacketClassifier::displaySummary() const {
+    cout << "Classifier: " << rules.size() << " rules, " << tuples.size() << " tuples, "
+        << entryCount << " entries" << endl;
+}
@@ -0,0 +1,89 @@
+#ifndef PACKETCLASSIFIER_H
+#define PACKETCLASSIFIER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ClassifierRule {
+    uint32_t source;
+    int sourceLength;
+    uint32_t destination;
+    int destinationLength;
+    int portLow;
+    int portHigh;
+    int qosClass;
+};
+
+// ACL-style QoS classifier using tuple space search.
+//
+// Rules are matched first-to-last, so a rule's index is its priority. Every
+// (source length, destination length, exact-or-range port) combination is a
+// tuple with its own hash table of masked keys. Exact-port tuples hash the
+// port too; range tuples keep, per key, a short run of port ranges in rule
+// order. A lookup probes one table per tuple, in order of the best rule the
+// tuple holds, and stops once no remaining tuple can beat the current match.
+// Cost depends on the number of distinct tuples, which stays small, rather
+// than on the number of rules. Each tuple also has a one-bit-per-slot
+// filter, eight bits per key, so tuples that cannot match are skipped with
+// a well-predicted branch instead of a hash table probe.
+class PacketClassifier {
+public:
+    static const int NO_MATCH = -1;
+
+    PacketClassifier();
+
+    size_t loadFromFile(const std::string& filename);
+    void addRule(const ClassifierRule& rule);
+    void clear();
+    void build();
+
+    int classify(uint32_t source, uint32_t destination, int port) const;
+    int classifyLinear(uint32_t source, uint32_t destination, int port) const;
+
+    size_t getRuleCount() const;
+    size_t getTupleCount() const;
+    size_t getEntryCount() const;
+    void displaySummary() const;
+
+private:
+    static const uint32_t NO_RULE = 0xFFFFFFFFu;
+
+    // rule is the rule index for exact-port tuples and the first candidate
+    // of the key's run for range tuples
+    struct TupleEntry {
+        uint32_t source;
+        uint32_t destination;
+        uint32_t port;
+        uint32_t rule;
+    };
+
+    struct PortCandidate {
+        int portLow;
+        int portHigh;
+        uint32_t rule;
+    };
+
+    struct Tuple {
+        uint32_t sourceMask;
+        uint32_t destinationMask;
+        bool exactPort;
+        uint32_t firstRule;
+        uint32_t tableMask;
+        uint32_t filterMask;
+        size_t offset;
+        size_t filterOffset;
+    };
+
+    std::vector<ClassifierRule> rules;
+    std::vector<Tuple> tuples;
+    std::vector<TupleEntry> entries;
+    std::vector<PortCandidate> candidates;
+    std::vector<uint64_t> filters;
+    size_t entryCount;
+
+    static uint32_t hashKey(uint32_t source, uint32_t destination, uint32_t port);
+};
+
+#endif
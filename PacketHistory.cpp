@@ -1,30 +1,50 @@
 ﻿#include "PacketHistory.h"
+#include "Clock.h"
 #include <iostream>
 #include <iomanip>
+#include <string_view>
 
 using namespace std;
 
-PacketHistory::PacketHistory() {
+PacketHistory::PacketHistory()
+    : PacketHistory(allocator_type()) {
+}
+
+PacketHistory::PacketHistory(const allocator_type& allocator)
+    : traceList(allocator), visitedRouters(allocator) {
     packetID = 0;
 }
 
-PacketHistory::PacketHistory(int packetID) {
+PacketHistory::PacketHistory(int packetID, const allocator_type& allocator)
+    : traceList(allocator), visitedRouters(allocator) {
     this->packetID = packetID;
 }
 
+PacketHistory::PacketHistory(const PacketHistory& other, const allocator_type& allocator)
+    : packetID(other.packetID), traceList(other.traceList, allocator), visitedRouters(other.visitedRouters, allocator) {
+}
+
+PacketHistory::PacketHistory(PacketHistory&& other, const allocator_type& allocator)
+    : packetID(other.packetID), traceList(move(other.traceList), allocator),
+    visitedRouters(move(other.visitedRouters), allocator) {
+}
+
 void PacketHistory::addTrace(const TraceEntry& entry) {
     traceList.push_back(entry);
-    visitedRouters.insert(entry.getRouterID());
+    string routerID = entry.getRouterID();
+    if (!hasVisitedRouter(routerID)) {
+        visitedRouters.emplace(routerID);
+    }
 }
 
 void PacketHistory::addTrace(const string& routerID, const string& action,
-    int queueDelay, int remainingTTL, const string& nextHop) {
+    long long queueDelay, int remainingTTL, const string& nextHop) {
     TraceEntry entry(routerID, action, queueDelay, remainingTTL, nextHop);
     addTrace(entry);
 }
 
 bool PacketHistory::hasVisitedRouter(const string& routerID) const {
-    return visitedRouters.find(routerID) != visitedRouters.end();
+    return visitedRouters.find(string_view(routerID)) != visitedRouters.end();
 }
 
 bool PacketHistory::detectLoop(const string& routerID) {
@@ -55,7 +75,7 @@ void PacketHistory::displayHistory() const {
 
     cout << "----------------------------------------" << endl;
     cout << "Total Hops: " << getHopCount()
-        << " | Total Delay: " << getTotalDelay() << "ms" << endl;
+        << " | Total Delay: " << Clock::toMilliseconds(getTotalDelay()) << "ms" << endl;
     cout << "Final Action: " << getFinalAction() << endl;
     cout << "========================================" << endl;
 }
@@ -77,7 +97,7 @@ void PacketHistory::displayCompactHistory() const {
 
     cout << " [" << getFinalAction() << ", "
         << getHopCount() << " hops, "
-        << getTotalDelay() << "ms]" << endl;
+        << Clock::toMilliseconds(getTotalDelay()) << "ms]" << endl;
 }
 
 void PacketHistory::displayReverseHistory() const {
@@ -104,15 +124,19 @@ size_t PacketHistory::getHopCount() const {
 }
 
 list<TraceEntry> PacketHistory::getTraceList() const {
-    return traceList;
+    return list<TraceEntry>(traceList.begin(), traceList.end());
 }
 
 set<string> PacketHistory::getVisitedRouters() const {
-    return visitedRouters;
+    set<string> routers;
+    for (const auto& router : visitedRouters) {
+        routers.emplace(router.data(), router.size());
+    }
+    return routers;
 }
 
-int PacketHistory::getTotalDelay() const {
-    int total = 0;
+long long PacketHistory::getTotalDelay() const {
+    long long total = 0;
     for (const auto& entry : traceList) {
         total += entry.getQueueDelay();
     }
@@ -1,24 +1,37 @@
 #ifndef PACKETHISTORY_H 
 #define PACKETHISTORY_H
 
+#include <functional>
 #include <list>
+#include <memory_resource>
 #include <set>
 #include <string>
 #include "TraceEntry.h"
 
+// Allocator-aware: trace nodes and visited router names come from the
+// history's memory resource.
 class PacketHistory {
 private:
     int packetID;
-    std::list<TraceEntry> traceList;  
-    std::set<std::string> visitedRouters; 
+    std::pmr::list<TraceEntry> traceList;  
+    std::pmr::set<std::pmr::string, std::less<>> visitedRouters; 
 
 public:
+    typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
     PacketHistory();
-    PacketHistory(int packetID);
+    explicit PacketHistory(const allocator_type& allocator);
+    PacketHistory(int packetID, const allocator_type& allocator = allocator_type());
+    PacketHistory(const PacketHistory& other) = default;
+    PacketHistory(PacketHistory&& other) = default;
+    PacketHistory(const PacketHistory& other, const allocator_type& allocator);
+    PacketHistory(PacketHistory&& other, const allocator_type& allocator);
+    PacketHistory& operator=(const PacketHistory& other) = default;
+    PacketHistory& operator=(PacketHistory&& other) = default;
 
     void addTrace(const TraceEntry& entry);
     void addTrace(const std::string& routerID, const std::string& action,
-        int queueDelay, int remainingTTL, const std::string& nextHop = "");
+        long long queueDelay, int remainingTTL, const std::string& nextHop = "");
 
     bool hasVisitedRouter(const std::string& routerID) const;
     bool detectLoop(const std::string& routerID);
@@ -32,7 +45,7 @@ public:
     std::list<TraceEntry> getTraceList() const;
     std::set<std::string> getVisitedRouters() const;
 
-    int getTotalDelay() const;
+    long long getTotalDelay() const;
     std::string getFinalAction() const;
     std::string getLastRouter() const;
 
@@ -0,0 +1,232 @@
+#include "PacketParser.h"
+#include "Clock.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+namespace {
+    void skipBlanks(const char*& cursor, const char* end) {
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) {
+            cursor++;
+        }
+    }
+
+    bool parseInteger(const char*& cursor, const char* end, int& value) {
+        skipBlanks(cursor, end);
+        bool negative = cursor < end && *cursor == '-';
+        if (negative) {
+            cursor++;
+        }
+        const char* digits = cursor;
+        long long number = 0;
+        while (cursor < end && *cursor >= '0' && *cursor <= '9' && number <= 0x7FFFFFFF) {
+            number = number * 10 + (*cursor - '0');
+            cursor++;
+        }
+        if (cursor == digits || number > 0x7FFFFFFF) {
+            return false;
+        }
+        value = static_cast<int>(negative ? -number : number);
+        skipBlanks(cursor, end);
+        return true;
+    }
+
+    // The field up to the next comma, without surrounding blanks
+    bool parseField(const char*& cursor, const char* end, const char*& fieldBegin, const char*& fieldEnd) {
+        skipBlanks(cursor, end);
+        fieldBegin = cursor;
+        while (cursor < end && *cursor != ',') {
+            cursor++;
+        }
+        fieldEnd = cursor;
+        while (fieldEnd > fieldBegin && (fieldEnd[-1] == ' ' || fieldEnd[-1] == '\t' || fieldEnd[-1] == '\r')) {
+            fieldEnd--;
+        }
+        return fieldEnd > fieldBegin;
+    }
+
+    bool expectComma(const char*& cursor, const char* end) {
+        if (cursor < end && *cursor == ',') {
+            cursor++;
+            return true;
+        }
+        return false;
+    }
+}
+
+PacketParser::PacketParser(int threadCount)
+    : threadCount(threadCount), chunkCount(0), skippedCount(0), parseTime(0) {
+    if (this->threadCount < 1) {
+        this->threadCount = static_cast<int>(thread::hardware_concurrency());
+    }
+    if (this->threadCount < 1) {
+        this->threadCount = 1;
+    }
+}
+
+size_t PacketParser::parseFile(const string& filename, vector<packets>& packetList) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        cout << "Error: Cannot open file " << filename << endl;
+        return 0;
+    }
+    return parse(file.getData(), file.getSize(), packetList);
+}
+
+// Appends the packets to packetList in file order.
+// Time Complexity: O(n / t) per thread for n bytes and t threads
+size_t PacketParser::parse(const char* data, size_t size, vector<packets>& packetList) {
+    long long start = Clock::now();
+    const char* end = data + size;
+
+    // Skip header
+    const char* body = data;
+    while (body < end && *body != '\n') {
+        body++;
+    }
+    if (body < end) {
+        body++;
+    }
+
+    size_t bodySize = static_cast<size_t>(end - body);
+    size_t chunks = bodySize / MIN_CHUNK_SIZE;
+    if (chunks > static_cast<size_t>(threadCount)) {
+        chunks = static_cast<size_t>(threadCount);
+    }
+    if (chunks < 1) {
+        chunks = 1;
+    }
+
+    // Every cut moves forward to just past a newline, so no line is split
+    vector<Chunk> parts(chunks);
+    const char* cut = body;
+    for (size_t i = 0; i < chunks; i++) {
+        parts[i].begin = cut;
+        const char* next = i + 1 == chunks ? end : body + bodySize / chunks * (i + 1);
+        if (next < cut) {
+            next = cut;
+        }
+        while (next < end && next > body && next[-1] != '\n') {
+            next++;
+        }
+        parts[i].end = next;
+        parts[i].lineCount = 0;
+        cut = next;
+    }
+
+    if (chunks == 1) {
+        parseChunk(parts[0]);
+    }
+    else {
+        vector<thread> workers;
+        for (Chunk& chunk : parts) {
+            workers.emplace_back(&PacketParser::parseChunk, ref(chunk));
+        }
+        for (thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Line 1 is the header
+    size_t total = packetList.size();
+    size_t lineNumber = 1;
+    skippedCount = 0;
+    for (Chunk& chunk : parts) {
+        total += chunk.packetList.size();
+        for (size_t line : chunk.malformedLines) {
+            if (skippedCount < MAX_WARNINGS) {
+                cout << "Warning: Skipping malformed packet at line " << lineNumber + line << endl;
+            }
+            skippedCount++;
+        }
+        lineNumber += chunk.lineCount;
+    }
+    if (skippedCount > MAX_WARNINGS) {
+        cout << "Warning: Skipped " << skippedCount << " malformed packets in total" << endl;
+    }
+
+    size_t first = packetList.size();
+    if (first == 0 && chunks == 1) {
+        packetList.swap(parts[0].packetList);
+    }
+    else {
+        packetList.reserve(total);
+        for (Chunk& chunk : parts) {
+            packetList.insert(packetList.end(), make_move_iterator(chunk.packetList.begin()),
+                make_move_iterator(chunk.packetList.end()));
+            vector<packets>().swap(chunk.packetList);
+        }
+    }
+
+    chunkCount = static_cast<int>(chunks);
+    parseTime = Clock::now() - start;
+    return total - first;
+}
+
+// Reserves one packet per line up front, so the chunk's vector never grows.
+void PacketParser::parseChunk(Chunk& chunk) {
+    chunk.packetList.reserve(count(chunk.begin, chunk.end, '\n') + 1);
+    const char* p = chunk.begin;
+
+    while (p < chunk.end) {
+        const char* lineEnd = p;
+        while (lineEnd < chunk.end && *lineEnd != '\n') {
+            lineEnd++;
+        }
+        chunk.lineCount++;
+
+        const char* cursor = p;
+        p = lineEnd + 1;
+
+        skipBlanks(cursor, lineEnd);
+        if (cursor == lineEnd) {
+            continue;
+        }
+        if (!parseLine(cursor, lineEnd, chunk.packetList)) {
+            chunk.malformedLines.push_back(chunk.lineCount);
+        }
+    }
+}
+
+bool PacketParser::parseLine(const char* cursor, const char* lineEnd, vector<packets>& packetList) {
+    int id = 0;
+    int port = 0;
+    int ttl = 0;
+    const char* sourceBegin = nullptr;
+    const char* sourceEnd = nullptr;
+    const char* destinationBegin = nullptr;
+    const char* destinationEnd = nullptr;
+
+    if (!parseInteger(cursor, lineEnd, id) || !expectComma(cursor, lineEnd) ||
+        !parseField(cursor, lineEnd, sourceBegin, sourceEnd) || !expectComma(cursor, lineEnd) ||
+        !parseField(cursor, lineEnd, destinationBegin, destinationEnd) || !expectComma(cursor, lineEnd) ||
+        !parseInteger(cursor, lineEnd, port) || !expectComma(cursor, lineEnd) ||
+        !parseInteger(cursor, lineEnd, ttl) || port < 0 || port > 65535) {
+        return false;
+    }
+
+    packetList.emplace_back(id, string(sourceBegin, sourceEnd), string(destinationBegin, destinationEnd), port, ttl);
+    return true;
+}
+
+int PacketParser::getThreadCount() const {
+    return threadCount;
+}
+
+int PacketParser::getChunkCount() const {
+    return chunkCount;
+}
+
+size_t PacketParser::getSkippedCount() const {
+    return skippedCount;
+}
+
+long long PacketParser::getParseTime() const {
+    return parseTime;
+}
@@ -0,0 +1,48 @@
+#ifndef PACKETPARSER_H
+#define PACKETPARSER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Packets.h"
+
+// Parser for "ID,Source,Destination,Port,TTL" packet files, the first line
+// being the header. The mapped file is cut into one chunk per thread at
+// newline boundaries; each thread parses its chunk into its own vector and
+// the chunks are appended to the output in file order. Malformed lines,
+// including ports outside 0..65535, are skipped and reported by line number.
+class PacketParser {
+public:
+    PacketParser(int threadCount = 0);
+
+    size_t parseFile(const std::string& filename, std::vector<packets>& packetList);
+    size_t parse(const char* data, size_t size, std::vector<packets>& packetList);
+
+    int getThreadCount() const;
+    int getChunkCount() const;
+    size_t getSkippedCount() const;
+    long long getParseTime() const;
+
+private:
+    // Chunks smaller than this are not worth a thread
+    static const size_t MIN_CHUNK_SIZE = 1 << 20;
+    static const size_t MAX_WARNINGS = 10;
+
+    struct Chunk {
+        const char* begin;
+        const char* end;
+        size_t lineCount;
+        std::vector<packets> packetList;
+        std::vector<size_t> malformedLines;    // relative to the chunk
+    };
+
+    int threadCount;
+    int chunkCount;
+    size_t skippedCount;
+    long long parseTime;
+
+    static void parseChunk(Chunk& chunk);
+    static bool parseLine(const char* cursor, const char* lineEnd, std::vector<packets>& packetList);
+};
+
+#endif
@@ -0,0 +1,414 @@
+#include "PacketSocket.h"
+#include "IPAddress.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#endif
+
+using namespace std;
+
+namespace {
+    // Receive slots hold one byte more than a packet, so an oversized
+    // datagram shows up as a wrong length instead of being cut silently
+    const size_t SLOT_SIZE = PacketSocket::WIRE_SIZE + 1;
+
+    void put16(unsigned char* buffer, uint32_t value) {
+        buffer[0] = static_cast<unsigned char>(value >> 8);
+        buffer[1] = static_cast<unsigned char>(value);
+    }
+
+    void put32(unsigned char* buffer, uint32_t value) {
+        put16(buffer, value >> 16);
+        put16(buffer + 2, value);
+    }
+
+    void put64(unsigned char* buffer, uint64_t value) {
+        put32(buffer, static_cast<uint32_t>(value >> 32));
+        put32(buffer + 4, static_cast<uint32_t>(value));
+    }
+
+    uint32_t get16(const unsigned char* buffer) {
+        return (static_cast<uint32_t>(buffer[0]) << 8) | buffer[1];
+    }
+
+    uint32_t get32(const unsigned char* buffer) {
+        return (get16(buffer) << 16) | get16(buffer + 2);
+    }
+
+    uint64_t get64(const unsigned char* buffer) {
+        return (static_cast<uint64_t>(get32(buffer)) << 32) | get32(buffer + 4);
+    }
+}
+
+PacketSocket::PacketSocket()
+    : descriptor(-1), receiveBuffer(MAX_BATCH * SLOT_SIZE), sendBuffer(MAX_BATCH * WIRE_SIZE),
+    receiveCalls(0), sendCalls(0), sendErrors(0), malformedCount(0) {
+}
+
+PacketSocket::~PacketSocket() {
+    close();
+}
+
+bool PacketSocket::bind(const string& address) {
+    return open(address, true);
+}
+
+bool PacketSocket::connect(const string& address) {
+    return open(address, false);
+}
+
+#ifdef _WIN32
+bool PacketSocket::open(const string&, bool) {
+    cout << "Error: Packet sockets are not supported on Windows" << endl;
+    return false;
+}
+
+void PacketSocket::close() {
+}
+
+size_t PacketSocket::receiveBatch(vector<packets>&, size_t) {
+    return 0;
+}
+
+size_t PacketSocket::sendBatch(const vector<packets>&, const vector<uint32_t>&) {
+    return 0;
+}
+#else
+bool PacketSocket::open(const string& address, bool listen) {
+    close();
+
+    int result = -1;
+    if (address.compare(0, 4, "udp:") == 0) {
+        size_t colon = address.rfind(':');
+        uint32_t host = 0;
+        int port = atoi(address.c_str() + colon + 1);
+        if (colon <= 4 || !IPAddress::parse(address.substr(4, colon - 4), host) || port <= 0 || port > 65535) {
+            cout << "Error: Malformed socket address " << address << endl;
+            return false;
+        }
+
+        sockaddr_in socketAddress;
+        memset(&socketAddress, 0, sizeof(socketAddress));
+        socketAddress.sin_family = AF_INET;
+        socketAddress.sin_port = htons(static_cast<uint16_t>(port));
+        socketAddress.sin_addr.s_addr = htonl(host);
+
+        descriptor = socket(AF_INET, SOCK_DGRAM, 0);
+        if (descriptor >= 0 && listen) {
+            result = ::bind(descriptor, reinterpret_cast<const sockaddr*>(&socketAddress), sizeof(socketAddress));
+        }
+        else if (descriptor >= 0) {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&socketAddress);
+            peerAddress.assign(bytes, bytes + sizeof(socketAddress));
+            result = 0;
+        }
+    }
+    else if (address.compare(0, 5, "unix:") == 0) {
+        string path = address.substr(5);
+        sockaddr_un socketAddress;
+        memset(&socketAddress, 0, sizeof(socketAddress));
+        if (path.empty() || path.size() >= sizeof(socketAddress.sun_path)) {
+            cout << "Error: Malformed socket address " << address << endl;
+            return false;
+        }
+        socketAddress.sun_family = AF_UNIX;
+        memcpy(socketAddress.sun_path, path.c_str(), path.size());
+
+        descriptor = socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (descriptor >= 0 && listen) {
+            unlink(path.c_str());
+            result = ::bind(descriptor, reinterpret_cast<const sockaddr*>(&socketAddress), sizeof(socketAddress));
+            if (result == 0) {
+                boundPath = path;
+            }
+        }
+        else if (descriptor >= 0) {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&socketAddress);
+            peerAddress.assign(bytes, bytes + sizeof(socketAddress));
+            result = 0;
+        }
+    }
+    else {
+        cout << "Error: Socket address must start with udp: or unix:, got " << address << endl;
+        return false;
+    }
+
+    if (descriptor < 0 || result < 0) {
+        cout << "Error: Cannot " << (listen ? "bind " : "open ") << address << ": " << strerror(errno) << endl;
+        close();
+        return false;
+    }
+
+    // Room for bursts while the router is busy with the previous batch
+    int bufferSize = 4 << 20;
+    setsockopt(descriptor, SOL_SOCKET, listen ? SO_RCVBUF : SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+    fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL, 0) | O_NONBLOCK);
+    return true;
+}
+
+void PacketSocket::close() {
+    if (descriptor >= 0) {
+        ::close(descriptor);
+        descriptor = -1;
+    }
+    if (!boundPath.empty()) {
+        unlink(boundPath.c_str());
+        boundPath.clear();
+    }
+    peerAddress.clear();
+}
+
+// Appends up to maxCount packets that are already waiting; never blocks.
+// Time Complexity: O(b) for a batch of b, one system call on Linux
+size_t PacketSocket::receiveBatch(vector<packets>& packetList, size_t maxCount) {
+    if (descriptor < 0) {
+        return 0;
+    }
+    if (maxCount > MAX_BATCH) {
+        maxCount = MAX_BATCH;
+    }
+
+    size_t lengths[MAX_BATCH];
+    size_t count = 0;
+#ifdef __linux__
+    mmsghdr headers[MAX_BATCH];
+    iovec vectors[MAX_BATCH];
+    memset(headers, 0, sizeof(headers[0]) * maxCount);
+    for (size_t i = 0; i < maxCount; i++) {
+        vectors[i].iov_base = &receiveBuffer[i * SLOT_SIZE];
+        vectors[i].iov_len = SLOT_SIZE;
+        headers[i].msg_hdr.msg_iov = &vectors[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+    int received = recvmmsg(descriptor, headers, static_cast<unsigned>(maxCount), MSG_DONTWAIT, nullptr);
+    receiveCalls++;
+    for (int i = 0; i < received; i++) {
+        lengths[count++] = headers[i].msg_len;
+    }
+#else
+    while (count < maxCount) {
+        ssize_t received = recv(descriptor, &receiveBuffer[count * SLOT_SIZE], SLOT_SIZE, MSG_DONTWAIT);
+        receiveCalls++;
+        if (received < 0) {
+            break;
+        }
+        lengths[count++] = static_cast<size_t>(received);
+    }
+#endif
+
+    size_t decoded = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (lengths[i] != WIRE_SIZE) {
+            malformedCount++;
+            continue;
+        }
+        packetList.push_back(decode(&receiveBuffer[i * SLOT_SIZE]));
+        decoded++;
+    }
+    return decoded;
+}
+
+// Sends in batches of MAX_BATCH; nextHops is parallel to packetList or
+// empty. Datagrams the socket will not take right now (full buffer, no
+// receiver) are dropped and counted as send errors.
+size_t PacketSocket::sendBatch(const vector<packets>& packetList, const vector<uint32_t>& nextHops) {
+    if (descriptor < 0 || peerAddress.empty()) {
+        return 0;
+    }
+
+    size_t sentTotal = 0;
+    for (size_t first = 0; first < packetList.size(); first += MAX_BATCH) {
+        size_t count = packetList.size() - first < MAX_BATCH ? packetList.size() - first : MAX_BATCH;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t nextHop = nextHops.empty() ? NO_HOP : nextHops[first + i];
+            encode(packetList[first + i], nextHop, &sendBuffer[i * WIRE_SIZE]);
+        }
+
+        size_t done = 0;
+#ifdef __linux__
+        mmsghdr headers[MAX_BATCH];
+        iovec vectors[MAX_BATCH];
+        memset(headers, 0, sizeof(headers[0]) * count);
+        for (size_t i = 0; i < count; i++) {
+            vectors[i].iov_base = &sendBuffer[i * WIRE_SIZE];
+            vectors[i].iov_len = WIRE_SIZE;
+            headers[i].msg_hdr.msg_name = &peerAddress[0];
+            headers[i].msg_hdr.msg_namelen = static_cast<socklen_t>(peerAddress.size());
+            headers[i].msg_hdr.msg_iov = &vectors[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        while (done < count) {
+            int sent = sendmmsg(descriptor, headers + done, static_cast<unsigned>(count - done), MSG_DONTWAIT);
+            sendCalls++;
+            if (sent <= 0) {
+                break;
+            }
+            done += static_cast<size_t>(sent);
+        }
+#else
+        while (done < count) {
+            ssize_t sent = sendto(descriptor, &sendBuffer[done * WIRE_SIZE], WIRE_SIZE, MSG_DONTWAIT,
+                reinterpret_cast<const sockaddr*>(&peerAddress[0]), static_cast<socklen_t>(peerAddress.size()));
+            sendCalls++;
+            if (sent < 0) {
+                break;
+            }
+            done++;
+        }
+#endif
+        sendErrors += count - done;
+        sentTotal += done;
+    }
+    return sentTotal;
+}
+#endif
+
+void PacketSocket::encode(const packets& packet, uint32_t nextHop, unsigned char* buffer) {
+    int ttl = packet.getTTL();
+    int qosClass = packet.getQosClass();
+    put32(buffer, static_cast<uint32_t>(packet.getId()));
+    put32(buffer + 4, packet.getSourceAddress());
+    put32(buffer + 8, packet.getDestinationAddress());
+    put16(buffer + 12, static_cast<uint32_t>(packet.getPort()));
+    buffer[14] = static_cast<unsigned char>(ttl < 0 ? 0 : (ttl > 255 ? 255 : ttl));
+    buffer[15] = static_cast<unsigned char>(qosClass < 0 || qosClass > 254 ? 255 : qosClass);
+    put32(buffer + 16, nextHop);
+    put64(buffer + 20, static_cast<uint64_t>(packet.getOriginTime()));
+}
+
+packets PacketSocket::decode(const unsigned char* buffer) {
+    packets packet(static_cast<int>(get32(buffer)), IPAddress::toString(get32(buffer + 4)),
+        IPAddress::toString(get32(buffer + 8)), static_cast<int>(get16(buffer + 12)), buffer[14]);
+    if (buffer[15] != 255) {
+        packet.setQosClass(buffer[15]);
+    }
+    packet.setOriginTime(static_cast<long long>(get64(buffer + 20)));
+    return packet;
+}
+
+bool PacketSocket::isOpen() const {
+    return descriptor >= 0;
+}
+
+int PacketSocket::getDescriptor() const {
+    return descriptor;
+}
+
+uint64_t PacketSocket::getReceiveCalls() const {
+    return receiveCalls;
+}
+
+uint64_t PacketSocket::getSendCalls() const {
+    return sendCalls;
+}
+
+uint64_t PacketSocket::getSendErrors() const {
+    return sendErrors;
+}
+
+uint64_t PacketSocket::getMalformedCount() const {
+    return malformedCount;
+}
+
+#if defined(__linux__)
+SocketPoller::SocketPoller()
+    : pollDescriptor(epoll_create1(0)) {
+}
+
+SocketPoller::~SocketPoller() {
+    if (pollDescriptor >= 0) {
+        ::close(pollDescriptor);
+    }
+}
+
+bool SocketPoller::add(const PacketSocket& socket) {
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = socket.getDescriptor();
+    if (pollDescriptor < 0 || epoll_ctl(pollDescriptor, EPOLL_CTL_ADD, socket.getDescriptor(), &event) < 0) {
+        return false;
+    }
+    descriptors.push_back(socket.getDescriptor());
+    return true;
+}
+
+int SocketPoller::wait(int timeoutMs, vector<int>& readyDescriptors) {
+    const int MAX_EVENTS = 16;
+    epoll_event events[MAX_EVENTS];
+    readyDescriptors.clear();
+    int ready = epoll_wait(pollDescriptor, events, MAX_EVENTS, timeoutMs);
+    if (ready < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    for (int i = 0; i < ready; i++) {
+        readyDescriptors.push_back(events[i].data.fd);
+    }
+    return ready;
+}
+#elif !defined(_WIN32)
+SocketPoller::SocketPoller()
+    : pollDescriptor(-1) {
+}
+
+SocketPoller::~SocketPoller() {
+}
+
+bool SocketPoller::add(const PacketSocket& socket) {
+    if (!socket.isOpen()) {
+        return false;
+    }
+    descriptors.push_back(socket.getDescriptor());
+    return true;
+}
+
+int SocketPoller::wait(int timeoutMs, vector<int>& readyDescriptors) {
+    vector<pollfd> entries(descriptors.size());
+    for (size_t i = 0; i < descriptors.size(); i++) {
+        entries[i].fd = descriptors[i];
+        entries[i].events = POLLIN;
+        entries[i].revents = 0;
+    }
+    readyDescriptors.clear();
+    int ready = poll(entries.data(), static_cast<nfds_t>(entries.size()), timeoutMs);
+    if (ready < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    for (const pollfd& entry : entries) {
+        if (entry.revents & POLLIN) {
+            readyDescriptors.push_back(entry.fd);
+        }
+    }
+    return static_cast<int>(readyDescriptors.size());
+}
+#else
+SocketPoller::SocketPoller()
+    : pollDescriptor(-1) {
+}
+
+SocketPoller::~SocketPoller() {
+}
+
+bool SocketPoller::add(const PacketSocket&) {
+    return false;
+}
+
+int SocketPoller::wait(int, vector<int>& readyDescriptors) {
+    readyDescriptors.clear();
+    return -1;
+}
+#endif
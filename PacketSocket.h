@@ -0,0 +1,89 @@
+#ifndef PACKETSOCKET_H
+#define PACKETSOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Packets.h"
+
+// Datagram socket carrying packets in a compact binary encoding, one packet
+// per datagram, so a separate local process can feed the router and read
+// what it forwards. Addresses are "udp:<IPv4 address>:<port>" or
+// "unix:<path>". bind() receives on an address, connect() sends to one;
+// the receiver need not exist yet, datagrams are addressed on every send.
+//
+// On Linux a batch is one recvmmsg/sendmmsg call and SocketPoller uses
+// epoll; other POSIX systems loop over recv/send and use poll. Windows is
+// not supported: open calls report an error and fail.
+//
+// Wire format, big-endian, WIRE_SIZE bytes:
+//   id u32 | source u32 | destination u32 | port u16 | TTL u8 | class u8 |
+//   next hop u32 | origin time u64
+// The class and next hop (a FIB next-hop index) are only set on egress.
+class PacketSocket {
+public:
+    static constexpr size_t WIRE_SIZE = 28;
+    static constexpr size_t MAX_BATCH = 64;
+    static constexpr uint32_t NO_HOP = 0xFFFFFFFFu;
+
+    PacketSocket();
+    ~PacketSocket();
+
+    PacketSocket(const PacketSocket&) = delete;
+    PacketSocket& operator=(const PacketSocket&) = delete;
+
+    bool bind(const std::string& address);
+    bool connect(const std::string& address);
+    void close();
+
+    size_t receiveBatch(std::vector<packets>& packetList, size_t maxCount = MAX_BATCH);
+    size_t sendBatch(const std::vector<packets>& packetList, const std::vector<uint32_t>& nextHops);
+
+    static void encode(const packets& packet, uint32_t nextHop, unsigned char* buffer);
+    static packets decode(const unsigned char* buffer);
+
+    bool isOpen() const;
+    int getDescriptor() const;
+    uint64_t getReceiveCalls() const;
+    uint64_t getSendCalls() const;
+    uint64_t getSendErrors() const;
+    uint64_t getMalformedCount() const;
+
+private:
+    int descriptor;
+    std::string boundPath;    // UNIX socket file to remove on close
+    std::vector<unsigned char> peerAddress;    // sockaddr to send to
+
+    std::vector<unsigned char> receiveBuffer;
+    std::vector<unsigned char> sendBuffer;
+
+    uint64_t receiveCalls;
+    uint64_t sendCalls;
+    uint64_t sendErrors;
+    uint64_t malformedCount;
+
+    bool open(const std::string& address, bool listen);
+};
+
+// Readiness of a set of PacketSockets: epoll on Linux, poll elsewhere.
+class SocketPoller {
+public:
+    SocketPoller();
+    ~SocketPoller();
+
+    SocketPoller(const SocketPoller&) = delete;
+    SocketPoller& operator=(const SocketPoller&) = delete;
+
+    bool add(const PacketSocket& socket);
+
+    // Waits up to timeoutMs (0 polls) and fills the readable descriptors;
+    // returns their count, or -1 on error
+    int wait(int timeoutMs, std::vector<int>& readyDescriptors);
+
+private:
+    int pollDescriptor;
+    std::vector<int> descriptors;
+};
+
+#endif
@@ -1,23 +1,65 @@
 #include "Packets.h"
+#include "IPAddress.h"
 #include <iostream>
 using namespace std;
 
-packets::packets() {
+packets::packets()
+    : packets(allocator_type()) {
+}
+
+packets::packets(const allocator_type& allocator)
+    : source(allocator), destination(allocator), priority(allocator) {
     this->id = 0;
     this->source = "";
     this->destination = "";
+    this->sourceAddress = 0;
+    this->destinationAddress = 0;
     this->port = 0;
     this->TTL = 0;
+    size = 1500;
     priority = "";
+    qosClass = -1;
+    enqueueTime = 0;
+    queueDelay = 0;
+    flowSlot = 0xFFFFFFFFu;
+    originTime = 0;
 }
 
-packets::packets(int id, const string& source, const string& destination, int port, int TTL) {
+packets::packets(int id, const string& source, const string& destination, int port, int TTL,
+    const allocator_type& allocator)
+    : source(allocator), destination(allocator), priority(allocator) {
     this->id = id;
     this->source = source;
     this->destination = destination;
+    this->sourceAddress = 0;
+    this->destinationAddress = 0;
+    IPAddress::parse(source, sourceAddress);
+    IPAddress::parse(destination, destinationAddress);
     this->port = port;
     this->TTL = TTL;
+    size = 1500;
     priority = "";
+    qosClass = -1;
+    enqueueTime = 0;
+    queueDelay = 0;
+    flowSlot = 0xFFFFFFFFu;
+    originTime = 0;
+}
+
+packets::packets(const packets& other, const allocator_type& allocator)
+    : id(other.id), source(other.source, allocator), destination(other.destination, allocator),
+    sourceAddress(other.sourceAddress), destinationAddress(other.destinationAddress), port(other.port),
+    TTL(other.TTL), size(other.size), priority(other.priority, allocator), qosClass(other.qosClass),
+    enqueueTime(other.enqueueTime), queueDelay(other.queueDelay), flowSlot(other.flowSlot),
+    originTime(other.originTime) {
+}
+
+packets::packets(packets&& other, const allocator_type& allocator)
+    : id(other.id), source(move(other.source), allocator), destination(move(other.destination), allocator),
+    sourceAddress(other.sourceAddress), destinationAddress(other.destinationAddress), port(other.port),
+    TTL(other.TTL), size(other.size), priority(move(other.priority), allocator), qosClass(other.qosClass),
+    enqueueTime(other.enqueueTime), queueDelay(other.queueDelay), flowSlot(other.flowSlot),
+    originTime(other.originTime) {
 }
 
 int packets::getId() const {
@@ -25,11 +67,19 @@ int packets::getId() const {
 }
 
 string packets::getSource() const {
-    return source;
+    return string(source.data(), source.size());
 }
 
 string packets::getDestination() const {
-    return destination;
+    return string(destination.data(), destination.size());
+}
+
+uint32_t packets::getSourceAddress() const {
+    return sourceAddress;
+}
+
+uint32_t packets::getDestinationAddress() const {
+    return destinationAddress;
 }
 
 int packets::getPort() const {
@@ -40,10 +90,43 @@ int packets::getTTL() const {
     return TTL;
 }
 
+// Size in bytes on the wire; 1500 unless a traffic source sets it.
+int packets::getSize() const {
+    return size;
+}
+
+int packets::getQosClass() const {
+    return qosClass;
+}
+
+long long packets::getEnqueueTime() const {
+    return enqueueTime;
+}
+
+long long packets::getQueueDelay() const {
+    return queueDelay;
+}
+
+uint32_t packets::getFlowSlot() const {
+    return flowSlot;
+}
+
+long long packets::getOriginTime() const {
+    return originTime;
+}
+
 void packets::setPriority(const string& priority) {
     this->priority = priority;
 }
 
+void packets::setQosClass(int qosClass) {
+    this->qosClass = qosClass;
+}
+
+void packets::setSize(int size) {
+    this->size = size;
+}
+
 void packets::decrementTTL() {
     if (TTL > 0) {
         TTL--;
@@ -54,6 +137,23 @@ void packets::setTTL(int TTL) {
     this->TTL = TTL;
 }
 
+void packets::markEnqueued(long long now) {
+    enqueueTime = now;
+    queueDelay = 0;
+}
+
+void packets::markDequeued(long long now) {
+    queueDelay = now - enqueueTime;
+}
+
+void packets::setFlowSlot(uint32_t flowSlot) {
+    this->flowSlot = flowSlot;
+}
+
+void packets::setOriginTime(long long originTime) {
+    this->originTime = originTime;
+}
+
 void packets::display() const {
     cout << "ID:" << id << " "
         << source << "->" << destination << " "
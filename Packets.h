@@ -1,29 +1,65 @@
 #ifndef PACKETS_H
 #define PACKETS_H
+#include <cstdint>
+#include <memory_resource>
 #include <string>
 
+// Allocator-aware: inside a pmr container the strings come from the
+// container's memory resource.
 class packets {
 private:
     int id;
-    std::string source;
-    std::string destination;
+    std::pmr::string source;
+    std::pmr::string destination;
+    uint32_t sourceAddress;
+    uint32_t destinationAddress;
     int port;
     int TTL;
-    std::string priority;
+    int size;
+    std::pmr::string priority;
+    int qosClass;
+    long long enqueueTime;
+    long long queueDelay;
+    uint32_t flowSlot;
+    long long originTime;    // sender's clock, carried unchanged for end-to-end latency
 
 public:
+    typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
     packets();
-    packets(int id, const std::string& source, const std::string& destination, int port, int TTL);
+    explicit packets(const allocator_type& allocator);
+    packets(int id, const std::string& source, const std::string& destination, int port, int TTL,
+        const allocator_type& allocator = allocator_type());
+    packets(const packets& other) = default;
+    packets(packets&& other) = default;
+    packets(const packets& other, const allocator_type& allocator);
+    packets(packets&& other, const allocator_type& allocator);
+    packets& operator=(const packets& other) = default;
+    packets& operator=(packets&& other) = default;
 
     int getId() const;
     std::string getSource() const;
     std::string getDestination() const;
+    uint32_t getSourceAddress() const;
+    uint32_t getDestinationAddress() const;
     int getPort() const;
     int getTTL() const;
+    int getSize() const;
+    int getQosClass() const;
+    long long getEnqueueTime() const;
+    long long getQueueDelay() const;
+    uint32_t getFlowSlot() const;
+    long long getOriginTime() const;
 
     void setPriority(const std::string& priority);
+    void setQosClass(int qosClass);
+    void setSize(int size);
     void decrementTTL();
     void setTTL(int TTL);
+    void markEnqueued(long long now);
+    void markDequeued(long long now);
+    void setFlowSlot(uint32_t flowSlot);
+    void setOriginTime(long long originTime);
     void display() const;
 };
 
@@ -0,0 +1,93 @@
+#include "PoolResource.h"
+
+using namespace std;
+
+PoolResource::PoolResource(pmr::memory_resource* upstream)
+    : upstream(upstream), slabs(nullptr), slabCount(0), blocksInUse(0) {
+    for (size_t sizeClass = 0; sizeClass < CLASS_COUNT; sizeClass++) {
+        freeLists[sizeClass] = nullptr;
+    }
+}
+
+PoolResource::~PoolResource() {
+    while (slabs != nullptr) {
+        Slab* next = slabs->next;
+        upstream->deallocate(slabs, slabs->size, alignof(max_align_t));
+        slabs = next;
+    }
+}
+
+// Carves a fresh slab into blocks of the class. The slab header takes the
+// first granule(s) so every block stays 16-byte aligned.
+void PoolResource::refill(size_t sizeClass) {
+    size_t blockSize = (sizeClass + 1) * GRANULE;
+    size_t headerSize = (sizeof(Slab) + GRANULE - 1) / GRANULE * GRANULE;
+    size_t slabSize = SLAB_SIZE;
+    if (headerSize + blockSize * 4 > slabSize) {
+        slabSize = headerSize + blockSize * 4;
+    }
+
+    Slab* slab = static_cast<Slab*>(upstream->allocate(slabSize, alignof(max_align_t)));
+    slab->next = slabs;
+    slab->size = slabSize;
+    slabs = slab;
+    slabCount++;
+
+    char* block = reinterpret_cast<char*>(slab) + headerSize;
+    char* end = reinterpret_cast<char*>(slab) + slabSize;
+    FreeBlock* head = freeLists[sizeClass];
+    while (block + blockSize <= end) {
+        FreeBlock* free = reinterpret_cast<FreeBlock*>(block);
+        free->next = head;
+        head = free;
+        block += blockSize;
+    }
+    freeLists[sizeClass] = head;
+}
+
+// Time Complexity: O(1), plus one slab carve per refill
+void* PoolResource::do_allocate(size_t bytes, size_t alignment) {
+    if (bytes == 0) {
+        bytes = 1;
+    }
+    size_t sizeClass = (bytes - 1) / GRANULE;
+    if (sizeClass >= CLASS_COUNT || alignment > GRANULE) {
+        return upstream->allocate(bytes, alignment);
+    }
+
+    if (freeLists[sizeClass] == nullptr) {
+        refill(sizeClass);
+    }
+    FreeBlock* block = freeLists[sizeClass];
+    freeLists[sizeClass] = block->next;
+    blocksInUse++;
+    return block;
+}
+
+void PoolResource::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    if (bytes == 0) {
+        bytes = 1;
+    }
+    size_t sizeClass = (bytes - 1) / GRANULE;
+    if (sizeClass >= CLASS_COUNT || alignment > GRANULE) {
+        upstream->deallocate(pointer, bytes, alignment);
+        return;
+    }
+
+    FreeBlock* block = static_cast<FreeBlock*>(pointer);
+    block->next = freeLists[sizeClass];
+    freeLists[sizeClass] = block;
+    blocksInUse--;
+}
+
+bool PoolResource::do_is_equal(const pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+size_t PoolResource::getSlabCount() const {
+    return slabCount;
+}
+
+size_t PoolResource::getBlocksInUse() const {
+    return blocksInUse;
+}
@@ -0,0 +1,118 @@
+#include "RouteUpdateStream.h"
+#include "IPAddress.h"
+#include <iostream>
+
+using namespace std;
+
+RouteUpdateStream::RouteUpdateStream()
+    : cursor(nullptr), lineNumber(0) {
+}
+
+bool RouteUpdateStream::open(const string& filename) {
+    if (!file.open(filename)) {
+        cout << "Error: Cannot open update file " << filename << endl;
+        return false;
+    }
+    rewind();
+    return true;
+}
+
+void RouteUpdateStream::rewind() {
+    cursor = file.getData();
+    lineNumber = 0;
+}
+
+// Clears batch and fills it with up to maxUpdates messages; returns the
+// number read, 0 at end of stream. Time Complexity: O(bytes consumed)
+size_t RouteUpdateStream::readBatch(vector<RouteUpdate>& batch, size_t maxUpdates) {
+    batch.clear();
+    if (cursor == nullptr) {
+        return 0;
+    }
+    const char* end = file.getData() + file.getSize();
+
+    while (cursor < end && batch.size() < maxUpdates) {
+        const char* lineEnd = cursor;
+        while (lineEnd < end && *lineEnd != '\n') {
+            lineEnd++;
+        }
+        const char* p = cursor;
+        cursor = lineEnd + 1;
+        lineNumber++;
+
+        while (p < lineEnd && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+        if (p == lineEnd || *p == '#' || *p == '\r') {
+            continue;
+        }
+
+        RouteUpdate update;
+        update.metric = 1;
+        if (*p == 'A' || *p == 'a') {
+            update.announce = true;
+        }
+        else if (*p == 'W' || *p == 'w') {
+            update.announce = false;
+        }
+        else {
+            cout << "Warning: Skipping unknown update type at line " << lineNumber << endl;
+            continue;
+        }
+        p++;
+        while (p < lineEnd && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+
+        update.prefixLength = -1;
+        if (IPAddress::parse(p, lineEnd, update.prefix) && p < lineEnd && *p == '/') {
+            p++;
+            update.prefixLength = 0;
+            while (p < lineEnd && *p >= '0' && *p <= '9') {
+                update.prefixLength = update.prefixLength * 10 + (*p - '0');
+                p++;
+            }
+        }
+        if (update.prefixLength < 0 || update.prefixLength > 32) {
+            cout << "Warning: Skipping malformed update at line " << lineNumber << endl;
+            continue;
+        }
+
+        if (update.announce) {
+            while (p < lineEnd && (*p == ' ' || *p == '\t')) {
+                p++;
+            }
+            while (p < lineEnd && *p != ' ' && *p != '\t' && *p != '\r') {
+                const char* hopStart = p;
+                while (p < lineEnd && *p != ',' && *p != ' ' && *p != '\t' && *p != '\r') {
+                    p++;
+                }
+                if (p > hopStart) {
+                    update.nextHops.push_back(string(hopStart, p));
+                }
+                if (p < lineEnd && *p == ',') {
+                    p++;
+                }
+            }
+            if (update.nextHops.empty()) {
+                cout << "Warning: Skipping announce without next hop at line " << lineNumber << endl;
+                continue;
+            }
+
+            while (p < lineEnd && (*p == ' ' || *p == '\t')) {
+                p++;
+            }
+            if (p < lineEnd && *p >= '0' && *p <= '9') {
+                update.metric = 0;
+                while (p < lineEnd && *p >= '0' && *p <= '9') {
+                    update.metric = update.metric * 10 + (*p - '0');
+                    p++;
+                }
+            }
+        }
+
+        batch.push_back(update);
+    }
+
+    return batch.size();
+}
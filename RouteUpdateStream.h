@@ -0,0 +1,34 @@
+#ifndef ROUTEUPDATESTREAM_H
+#define ROUTEUPDATESTREAM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+struct RouteUpdate {
+    bool announce;
+    uint32_t prefix;
+    int prefixLength;
+    std::vector<std::string> nextHops;
+    int metric;
+};
+
+// Replayable reader for route update files, one message per line:
+//   A <prefix>/<len> <nextHop>[,<nextHop>...] [metric]    announce
+//   W <prefix>/<len>                                        withdraw
+class RouteUpdateStream {
+private:
+    MappedFile file;
+    const char* cursor;
+    size_t lineNumber;
+
+public:
+    RouteUpdateStream();
+
+    bool open(const std::string& filename);
+    size_t readBatch(std::vector<RouteUpdate>& batch, size_t maxUpdates);
+    void rewind();
+};
+
+#endif
@@ -1,26 +1,107 @@
 #include "RouterDriver.h"
+#include "Clock.h"
+#include "IPAddress.h"
+#include "LoadGenerator.h"
+#include "MappedFile.h"
+#include "Simulator.h"
+#include "NetworkSimulator.h"
+#include "Topology.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
 using namespace std;
 
 RouterDriver::RouterDriver(const string& filename, int maxQueueSize)
-    : inputFile(filename) {
-    qos = new QoService(maxQueueSize);
-    routingTable = new RoutingTable();
+    : inputFile(filename), arena(&heap), pool(&arena), routerID("CoreRouter"), packetHistories(&pool) {
+    qos = new QoService(maxQueueSize, &pool);
+    routingTable = new RoutingTable(&pool);
+    forwardingTable = new ForwardingTable();
+    flowTable = new FlowTable();
+    classifier = new PacketClassifier();
+    qos->setFlowTable(flowTable);
 }
 
 RouterDriver::~RouterDriver() {
     cleanup();
 }
 
+void RouterDriver::setRouteFile(const string& filename) {
+    routeFile = filename;
+}
+
+void RouterDriver::setFibSnapshot(const string& filename) {
+    fibSnapshot = filename;
+}
+
+void RouterDriver::setUpdateFile(const string& filename) {
+    updateFile = filename;
+}
+
+void RouterDriver::setRuleFile(const string& filename) {
+    ruleFile = filename;
+}
+
+void RouterDriver::setTrafficFile(const string& filename) {
+    trafficFile = filename;
+}
+
 void RouterDriver::initializeComponents() {
     cout << "Initializing Router Components..." << endl;
+    cout << "Clock source: " << Clock::getSource()
+        << " (" << Clock::getTicksPerNanosecond() << " ticks/ns)" << endl;
+}
+
+// Compiles the QoS rule file. Without rules QoService falls back to the
+// well-known/registered/dynamic port ranges.
+void RouterDriver::configureClassifier() {
+    cout << "Configuring Classifier..." << endl;
+    if (ruleFile.empty() || classifier->loadFromFile(ruleFile) == 0) {
+        cout << "Using default port-range classification" << endl;
+        return;
+    }
+
+    long long start = Clock::now();
+    classifier->build();
+    classifier->displaySummary();
+    cout << "Classifier compiled in " << Clock::toMilliseconds(Clock::now() - start) << "ms" << endl;
+    qos->setClassifier(classifier);
 }
 
+// Startup order: map a snapshot that matches the route file, otherwise
+// bulk-load the route file (or the built-in defaults), compile the FIB and
+// write a fresh snapshot for the next start.
 void RouterDriver::configureRoutingTable() {
     cout << "Configuring Routing Table..." << endl;
+    long long start = Clock::now();
+    uint64_t sourceVersion = getRouteFileVersion();
 
+    if (!fibSnapshot.empty() && forwardingTable->loadSnapshot(fibSnapshot, sourceVersion)) {
+        cout << "Mapped FIB snapshot " << fibSnapshot << " in "
+            << Clock::toMilliseconds(Clock::now() - start) << "ms" << endl;
+        forwardingTable->displaySummary();
+        return;
+    }
+
+    if (routeFile.empty() || routingTable->loadFromFile(routeFile) == 0) {
+        configureDefaultRoutes();
+    }
+
+    forwardingTable->build(*routingTable);
+    cout << "Built FIB in " << Clock::toMilliseconds(Clock::now() - start) << "ms" << endl;
+
+    if (!fibSnapshot.empty() && forwardingTable->saveSnapshot(fibSnapshot, sourceVersion)) {
+        cout << "Saved FIB snapshot " << fibSnapshot << endl;
+    }
+
+    if (routingTable->getRouteCount() <= 64) {
+        routingTable->displayRoutingTable();
+    }
+    forwardingTable->displaySummary();
+}
+
+void RouterDriver::configureDefaultRoutes() {
     routingTable->addRoute("192.168.1.0", 24, "Router_A", 1);
     routingTable->addRoute("192.168.2.0", 24, "Router_B", 1);
     routingTable->addRoute("192.168.0.0", 16, "Router_C", 2);
@@ -28,10 +109,70 @@ void RouterDriver::configureRoutingTable() {
     routingTable->addRoute("172.16.0.0", 12, "Router_E", 2);
     routingTable->addRoute("172.20.0.0", 16, "Router_F", 1);
     routingTable->addRoute("0.0.0.0", 0, "DefaultGateway", 10);
+}
+
+// Snapshots are tagged with a hash of the route file's contents, so any edit
+// forces a rebuild, however quickly it follows the last one.
+// Time Complexity: O(n) for an n-byte route file, 8 bytes per step
+uint64_t RouterDriver::getRouteFileVersion() const {
+    MappedFile file;
+    if (routeFile.empty() || !file.open(routeFile)) {
+        return 0;
+    }
+
+    const char* data = file.getData();
+    size_t size = file.getSize();
+    uint64_t hash = 0xCBF29CE484222325ull ^ size;
+    for (size_t offset = 0; offset < size; offset += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        memcpy(&word, data + offset, min(sizeof(word), size - offset));
+        hash = (hash ^ word) * 0x100000001B3ull;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+// Replays the update file in batches. Lookups cannot run while a batch is
+// being applied, so the longest batch is the worst-case lookup stall.
+void RouterDriver::applyRouteUpdates() {
+    RouteUpdateStream stream;
+    if (!stream.open(updateFile)) {
+        return;
+    }
+
+    cout << "\nApplying route updates from " << updateFile << "..." << endl;
+
+    vector<RouteUpdate> batch;
+    batch.reserve(UPDATE_BATCH_SIZE);
+    size_t totalUpdates = 0;
+    size_t batches = 0;
+    long long totalTime = 0;
+    long long worstStall = 0;
+
+    while (stream.readBatch(batch, UPDATE_BATCH_SIZE) > 0) {
+        long long start = Clock::now();
+        forwardingTable->applyUpdates(batch);
+        long long elapsed = Clock::now() - start;
 
-    routingTable->displayRoutingTable();
+        totalTime += elapsed;
+        worstStall = max(worstStall, elapsed);
+        totalUpdates += batch.size();
+        batches++;
+    }
+
+    cout << "Applied " << totalUpdates << " updates in " << batches << " batches ("
+        << Clock::toMilliseconds(totalTime) << "ms)" << endl;
+    if (totalTime > 0) {
+        cout << "Update throughput: " << static_cast<long long>(totalUpdates * 1e9 / totalTime)
+            << " updates/s" << endl;
+    }
+    cout << "Worst-case lookup stall: " << Clock::toMilliseconds(worstStall) << "ms" << endl;
+    forwardingTable->displaySummary();
 }
 
+// Without QoS rules the configuration is the fixed port-range policy, so
+// packets take the compiled DefaultForwardingPath; rule files need the
+// runtime-configured QoService.
 void RouterDriver::processPackets() {
     cout << "\nReading packets from file..." << endl;
 
@@ -42,9 +183,27 @@ void RouterDriver::processPackets() {
         return;
     }
 
+    FlowCachedFib fib(flowTable, forwardingTable);
+    if (classifier->getRuleCount() == 0) {
+        cout << "Forwarding path: compiled (port ranges, strict priority, flow-cached FIB)" << endl;
+        DefaultForwardingPath path(fib, qos->getMaxQueueSize(), &pool);
+        forwardPackets(path, packetList);
+    }
+    else {
+        cout << "Forwarding path: runtime (QoS rules)" << endl;
+        RuntimeForwardingPath path(qos, fib);
+        forwardPackets(path, packetList);
+    }
+}
+
+template<typename Path>
+void RouterDriver::forwardPackets(Path& path, const vector<packets>& packetList) {
     cout << "Classifying packets by QoS..." << endl;
-    qos->classifyPackets(packetList);
-    qos->displayQueueStatus();
+    for (size_t i = 0; i < packetList.size(); i++) {
+        packets packet = packetList[i];
+        path.enqueuePacket(packet, Clock::now());
+    }
+    path.displayQueueStatus();
 
     cout << "\nProcessing packets..." << endl;
 
@@ -52,14 +211,9 @@ void RouterDriver::processPackets() {
     int droppedTTL = 0;
     int droppedNoRoute = 0;
     int packetNumber = 1;
+    packets packet;
 
-    while (!qos->allQueuesEmpty()) {
-        packets packet = qos->getNextPacket();
-
-        if (packet.getId() == 0) {
-            break;
-        }
-
+    while (path.dequeuePacket(packet, Clock::now())) {
         cout << "\nPacket " << packetNumber << " [ID:" << packet.getId()
             << "] " << packet.getSource() << " -> " << packet.getDestination()
             << " TTL:" << packet.getTTL();
@@ -68,20 +222,24 @@ void RouterDriver::processPackets() {
 
         if (packet.getTTL() <= 0) {
             cout << " [DROPPED - TTL Expired]" << endl;
+            recordTrace(packet, "DROPPED_TTL");
             droppedTTL++;
             packetNumber++;
             continue;
         }
 
-        RouterEntry* route = routingTable->findBestRoute(packet.getDestination());
+        uint32_t member = path.routePacket(packet, Clock::now());
 
-        if (route != nullptr) {
-            cout << " [FORWARDED to " << route->getNextHop() << "]" << endl;
+        if (member != ForwardingTable::NO_ROUTE) {
+            string nextHop = forwardingTable->getNextHop(forwardingTable->recordForward(member));
+            cout << " [FORWARDED to " << nextHop << "]" << endl;
+            recordTrace(packet, "FORWARDED", nextHop);
             qos->setForwardedStatus(true);
             forwardedCount++;
         }
         else {
             cout << " [DROPPED - No Route]" << endl;
+            recordTrace(packet, "DROPPED_NO_ROUTE");
             qos->setForwardedStatus(false);
             droppedNoRoute++;
         }
@@ -89,22 +247,44 @@ void RouterDriver::processPackets() {
         packetNumber++;
     }
 
+    size_t expiredFlows = flowTable->expire(Clock::now());
+
     cout << "\n--- Processing Summary ---" << endl;
     cout << "Total Packets: " << (packetNumber - 1) << endl;
     cout << "Forwarded: " << forwardedCount << endl;
     cout << "Dropped (TTL): " << droppedTTL << endl;
     cout << "Dropped (No Route): " << droppedNoRoute << endl;
+    cout << "Avg Queue Delay: " << Clock::toMilliseconds(path.getAverageQueueDelay()) << "ms" << endl;
+    cout << "Expired Flows: " << expiredFlows << endl;
+}
+
+void RouterDriver::recordTrace(const packets& packet, const string& action, const string& nextHop) {
+    auto it = packetHistories.find(packet.getId());
+    if (it == packetHistories.end()) {
+        it = packetHistories.emplace(packet.getId(), PacketHistory(packet.getId())).first;
+    }
+    it->second.addTrace(routerID, action, packet.getQueueDelay(), packet.getTTL(), nextHop);
 }
 
 void RouterDriver::displayStatistics() {
     cout << "\n--- Final Statistics ---" << endl;
-    cout << "Total Routes: " << routingTable->getRouteCount() << endl;
+    cout << "Total Routes: " << forwardingTable->getRouteCount() << endl;
+    forwardingTable->displayGroupStats();
+    flowTable->displayStats();
+    heap.displayStats();
+
+    for (const auto& pair : packetHistories) {
+        pair.second.displayCompactHistory();
+    }
     qos->displayQueueStatus();
 }
 
 void RouterDriver::cleanup() {
     delete qos;
     delete routingTable;
+    delete forwardingTable;
+    delete flowTable;
+    delete classifier;
 }
 
 void RouterDriver::run() {
@@ -114,10 +294,221 @@ void RouterDriver::run() {
 
     initializeComponents();
     configureRoutingTable();
+    configureClassifier();
+    if (!updateFile.empty()) {
+        applyRouteUpdates();
+    }
     processPackets();
     displayStatistics();
 
     cout << "\n========================================" << endl;
     cout << "     SIMULATION COMPLETED" << endl;
     cout << "========================================" << endl;
-}
\ No newline at end of file
+}
+
+// Discrete-event run: the traffic file drives arrivals in virtual time
+// through a separate QoService with realistic queue sizes, sharing the
+// compiled FIB and classifier rules.
+void RouterDriver::runSimulation(long long duration) {
+    cout << "========================================" << endl;
+    cout << "     DISCRETE-EVENT SIMULATION" << endl;
+    cout << "========================================" << endl;
+
+    initializeComponents();
+    configureRoutingTable();
+    configureClassifier();
+
+    QoService simulatedQos(SIMULATION_QUEUE_SIZE, &pool);
+    FlowTable simulatedFlows;
+    simulatedQos.setFlowTable(&simulatedFlows);
+    if (classifier->getRuleCount() > 0) {
+        simulatedQos.setClassifier(classifier);
+    }
+
+    Simulator simulator(&simulatedQos, forwardingTable, &pool);
+    if (trafficFile.empty() || simulator.loadTraffic(trafficFile) == 0) {
+        cout << "Error: No traffic sources. Exiting..." << endl;
+        return;
+    }
+
+    cout << "Simulating " << Clock::toMilliseconds(duration) << "ms..." << endl;
+    long long allocationsBefore = heap.getAllocationCount();
+    simulator.run(duration);
+    simulator.displayResults();
+    cout << "Memory: " << heap.getAllocationCount() - allocationsBefore << " heap allocations during the run" << endl;
+    forwardingTable->displayGroupStats();
+}
+
+void RouterDriver::runTopology(const string& filename, long long duration, int threadCount) {
+    cout << "========================================" << endl;
+    cout << "     NETWORK SIMULATION" << endl;
+    cout << "========================================" << endl;
+
+    initializeComponents();
+    configureClassifier();
+
+    Topology topology(SIMULATION_QUEUE_SIZE);
+    if (topology.loadFromFile(filename) == 0) {
+        cout << "Error: No routers in topology. Exiting..." << endl;
+        return;
+    }
+    topology.build(classifier->getRuleCount() > 0 ? classifier : nullptr);
+    topology.displaySummary();
+
+    NetworkSimulator simulator(&topology, threadCount);
+    cout << "Simulating " << Clock::toMilliseconds(duration) << "ms on " << threadCount << " threads..." << endl;
+    simulator.run(duration);
+    simulator.displayResults();
+}
+
+// Forwards packets arriving on the ingress socket to the egress socket
+// until duration has passed, through the same forwarding paths as run().
+void RouterDriver::runSocket(const string& ingress, const string& egress, long long duration) {
+    cout << "========================================" << endl;
+    cout << "     SOCKET FORWARDING" << endl;
+    cout << "========================================" << endl;
+
+    initializeComponents();
+    configureRoutingTable();
+    configureClassifier();
+
+    PacketSocket input;
+    PacketSocket output;
+    if (!input.bind(ingress) || !output.connect(egress)) {
+        cout << "Error: Socket setup failed. Exiting..." << endl;
+        return;
+    }
+
+    FlowTable socketFlows;
+    FlowCachedFib fib(&socketFlows, forwardingTable);
+    cout << "Serving " << ingress << " -> " << egress << " for " << Clock::toMilliseconds(duration) << "ms" << endl;
+    if (classifier->getRuleCount() == 0) {
+        cout << "Forwarding path: compiled (port ranges, strict priority, flow-cached FIB)" << endl;
+        DefaultForwardingPath path(fib, SOCKET_QUEUE_SIZE, &pool);
+        serveSocket(path, input, output, duration);
+    }
+    else {
+        cout << "Forwarding path: runtime (QoS rules)" << endl;
+        QoService socketQos(SOCKET_QUEUE_SIZE, &pool);
+        socketQos.setFlowTable(&socketFlows);
+        socketQos.setClassifier(classifier);
+        RuntimeForwardingPath path(&socketQos, fib);
+        serveSocket(path, input, output, duration);
+    }
+    forwardingTable->displayGroupStats();
+}
+
+// Event loop: wait for the ingress socket, then drain it one recvmmsg batch
+// at a time; each batch is queued, scheduled and routed, and whatever is
+// forwarded leaves in one sendmmsg before the next batch is read.
+template<typename Path>
+void RouterDriver::serveSocket(Path& path, PacketSocket& input, PacketSocket& output, long long duration) {
+    SocketPoller poller;
+    if (!poller.add(input)) {
+        cout << "Error: Cannot watch the ingress socket" << endl;
+        return;
+    }
+
+    vector<packets> received;
+    vector<packets> forwarded;
+    vector<uint32_t> nextHops;
+    vector<int> ready;
+    received.reserve(PacketSocket::MAX_BATCH);
+    forwarded.reserve(SOCKET_QUEUE_SIZE);
+    nextHops.reserve(SOCKET_QUEUE_SIZE);
+    packets packet;
+
+    long long receivedCount = 0;
+    long long batchCount = 0;
+    long long sentCount = 0;
+    long long droppedTTL = 0;
+    long long droppedNoRoute = 0;
+    long long droppedQueue = 0;
+    long long totalLatency = 0;
+    long long maxLatency = 0;
+    long long firstArrival = 0;
+    long long lastDeparture = 0;
+
+    long long end = Clock::now() + duration;
+    for (long long now = Clock::now(); now < end; now = Clock::now()) {
+        long long remaining = (end - now) / 1000000 + 1;
+        if (poller.wait(static_cast<int>(remaining < 100 ? remaining : 100), ready) <= 0) {
+            continue;
+        }
+
+        while (true) {
+            received.clear();
+            size_t count = input.receiveBatch(received);
+            if (count == 0) {
+                break;
+            }
+            long long arrival = Clock::now();
+            if (receivedCount == 0) {
+                firstArrival = arrival;
+            }
+            receivedCount += static_cast<long long>(count);
+            batchCount++;
+
+            for (packets& incoming : received) {
+                if (!path.enqueuePacket(incoming, arrival)) {
+                    droppedQueue++;
+                }
+            }
+
+            forwarded.clear();
+            nextHops.clear();
+            while (path.dequeuePacket(packet, arrival)) {
+                packet.decrementTTL();
+                if (packet.getTTL() <= 0) {
+                    droppedTTL++;
+                    continue;
+                }
+                uint32_t member = path.routePacket(packet, arrival);
+                if (member == ForwardingTable::NO_ROUTE) {
+                    droppedNoRoute++;
+                    continue;
+                }
+                nextHops.push_back(forwardingTable->recordForward(member));
+                forwarded.push_back(packet);
+            }
+
+            sentCount += static_cast<long long>(output.sendBatch(forwarded, nextHops));
+            long long departure = Clock::now();
+            totalLatency += (departure - arrival) * static_cast<long long>(forwarded.size());
+            if (!forwarded.empty() && departure - arrival > maxLatency) {
+                maxLatency = departure - arrival;
+            }
+            lastDeparture = departure;
+        }
+    }
+
+    long long activeTime = lastDeparture - firstArrival;
+    cout << "\n--- Socket Forwarding Summary ---" << endl;
+    cout << "Received: " << receivedCount << " packets in " << batchCount << " batches ("
+        << (batchCount > 0 ? static_cast<double>(receivedCount) / batchCount : 0) << " per call), "
+        << input.getMalformedCount() << " malformed" << endl;
+    cout << "Forwarded: " << sentCount << ", Send errors: " << output.getSendErrors() << endl;
+    cout << "Dropped (TTL): " << droppedTTL << ", Dropped (No Route): " << droppedNoRoute
+        << ", Dropped (Queue): " << droppedQueue << endl;
+    cout << "Throughput: " << (activeTime > 0 ? receivedCount * 1e9 / activeTime : 0) << " packets/s" << endl;
+    cout << "Router latency (receive to send): avg "
+        << (sentCount > 0 ? totalLatency / sentCount / 1000.0 : 0) << "us, max " << maxLatency / 1000.0 << "us" << endl;
+}
+
+// The other end of runSocket(), for a second process: replays the input
+// file's packets into the router and measures what comes back.
+void RouterDriver::runGenerator(const string& ingress, const string& egress, long long duration, double rate) {
+    vector<packets> packetList = qos->readPacketsFromFile(inputFile);
+    if (packetList.empty()) {
+        cout << "Error: No packets loaded. Exiting..." << endl;
+        return;
+    }
+
+    LoadGenerator generator(packetList);
+    cout << "Sending to " << ingress << ", receiving on " << egress << " for "
+        << Clock::toMilliseconds(duration) << "ms at " << (rate > 0 ? to_string(static_cast<long long>(rate)) : "full")
+        << " packets/s" << endl;
+    if (generator.run(ingress, egress, duration, rate)) {
+        generator.displayResults();
+    }
+}
@@ -1,27 +1,78 @@
 #ifndef ROUTERDRIVER_H
 #define ROUTERDRIVER_H
 
+#include <map>
+#include <memory_resource>
 #include <string>
+#include <vector>
+#include "AllocationCounter.h"
+#include "PoolResource.h"
 #include "qoservice.h"
 #include "RoutingTable.h"
+#include "ForwardingTable.h"
+#include "FlowTable.h"
+#include "PacketClassifier.h"
+#include "PacketHistory.h"
+#include "ForwardingPolicy.h"
+#include "PacketSocket.h"
 
 class RouterDriver {
 private:
     QoService* qos;
     RoutingTable* routingTable;
+    ForwardingTable* forwardingTable;
+    FlowTable* flowTable;
+    PacketClassifier* classifier;
     std::string inputFile;
+    std::string routeFile;
+    std::string fibSnapshot;
+    std::string updateFile;
+    std::string ruleFile;
+    std::string trafficFile;
+
+    static const size_t UPDATE_BATCH_SIZE = 1024;
+    static const int SIMULATION_QUEUE_SIZE = 256;
+    static const int SOCKET_QUEUE_SIZE = 256;
+
+    // Queues, routes and histories allocate from one pool; the counter
+    // under it sees only the pool's trips to the heap
+    AllocationCounter heap;
+    std::pmr::monotonic_buffer_resource arena;
+    PoolResource pool;
+
+    std::string routerID;
+    std::pmr::map<int, PacketHistory> packetHistories;
 
     void initializeComponents();
     void configureRoutingTable();
+    void configureClassifier();
+    void configureDefaultRoutes();
+    uint64_t getRouteFileVersion() const;
+    void applyRouteUpdates();
     void processPackets();
+    template<typename Path>
+    void forwardPackets(Path& path, const std::vector<packets>& packetList);
+    template<typename Path>
+    void serveSocket(Path& path, PacketSocket& input, PacketSocket& output, long long duration);
     void displayStatistics();
+    void recordTrace(const packets& packet, const std::string& action, const std::string& nextHop = "");
     void cleanup();
 
 public:
     RouterDriver(const std::string& filename = "file.txt", int maxQueueSize = 10);
     ~RouterDriver();
 
+    void setRouteFile(const std::string& filename);
+    void setFibSnapshot(const std::string& filename);
+    void setUpdateFile(const std::string& filename);
+    void setRuleFile(const std::string& filename);
+    void setTrafficFile(const std::string& filename);
+
     void run();
+    void runSimulation(long long duration);
+    void runTopology(const std::string& filename, long long duration, int threadCount);
+    void runSocket(const std::string& ingress, const std::string& egress, long long duration);
+    void runGenerator(const std::string& ingress, const std::string& egress, long long duration, double rate);
 };
 
 #endif
\ No newline at end of file
@@ -1,9 +1,15 @@
 ﻿#include "RouterEntry.h"
 #include <iostream>
+#include <string_view>
 
 using namespace std;
 
-RouterEntry::RouterEntry() {
+RouterEntry::RouterEntry()
+    : RouterEntry(allocator_type()) {
+}
+
+RouterEntry::RouterEntry(const allocator_type& allocator)
+    : networkPrefix(allocator), nextHop(allocator), nextHops(allocator) {
     networkPrefix = "";
     prefixLength = 0;
     nextHop = "";
@@ -11,19 +17,51 @@ RouterEntry::RouterEntry() {
 }
 
 RouterEntry::RouterEntry(const string& networkPrefix, int prefixLength,
-    const string& nextHop, int metric) {
+    const string& nextHop, int metric, const allocator_type& allocator)
+    : networkPrefix(allocator), nextHop(allocator), nextHops(allocator) {
     this->networkPrefix = networkPrefix;
     this->prefixLength = prefixLength;
     this->nextHop = nextHop;
+    this->nextHops.emplace_back(nextHop);
     this->metric = metric;
 }
 
+RouterEntry::RouterEntry(const RouterEntry& other, const allocator_type& allocator)
+    : networkPrefix(other.networkPrefix, allocator), prefixLength(other.prefixLength),
+    nextHop(other.nextHop, allocator), nextHops(other.nextHops, allocator), metric(other.metric) {
+}
+
+RouterEntry::RouterEntry(RouterEntry&& other, const allocator_type& allocator)
+    : networkPrefix(move(other.networkPrefix), allocator), prefixLength(other.prefixLength),
+    nextHop(move(other.nextHop), allocator), nextHops(move(other.nextHops), allocator), metric(other.metric) {
+}
+
 string RouterEntry::getNetworkPrefix() const {
-    return networkPrefix;
+    return string(networkPrefix.data(), networkPrefix.size());
 }
 
 string RouterEntry::getNextHop() const {
-    return nextHop;
+    return string(nextHop.data(), nextHop.size());
+}
+
+// Equal-cost next hops; the first one is also returned by getNextHop().
+vector<string> RouterEntry::getNextHops() const {
+    vector<string> hops;
+    for (const auto& hop : nextHops) {
+        hops.emplace_back(hop.data(), hop.size());
+    }
+    return hops;
+}
+
+string RouterEntry::getNextHopList() const {
+    string list;
+    for (size_t i = 0; i < nextHops.size(); i++) {
+        if (i > 0) {
+            list += ",";
+        }
+        list += nextHops[i];
+    }
+    return list;
 }
 
 int RouterEntry::getPrefixLength() const {
@@ -40,6 +78,21 @@ void RouterEntry::setNetworkPrefix(const string& networkPrefix) {
 
 void RouterEntry::setNextHop(const string& nextHop) {
     this->nextHop = nextHop;
+    nextHops.clear();
+    nextHops.emplace_back(nextHop);
+}
+
+bool RouterEntry::addNextHop(const string& nextHop) {
+    for (const auto& hop : nextHops) {
+        if (string_view(hop) == nextHop) {
+            return false;
+        }
+    }
+    if (nextHops.empty()) {
+        this->nextHop = nextHop;
+    }
+    nextHops.emplace_back(nextHop);
+    return true;
 }
 
 void RouterEntry::setPrefixLength(int prefixLength) {
@@ -52,6 +105,6 @@ void RouterEntry::setMetric(int metric) {
 
 void RouterEntry::display() {
     cout << networkPrefix << "/" << prefixLength
-        << " -> " << nextHop
+        << " -> " << getNextHopList()
         << " (Metric:" << metric << ")" << endl;
 }
\ No newline at end of file
@@ -1,23 +1,40 @@
 #ifndef ROUTERENTRY_H 
 #define ROUTERENTRY_H
+#include <memory_resource>
 #include <string>
+#include <vector>
+// Allocator-aware, so entries in a RoutingTable use the table's memory resource.
 class RouterEntry {
 private: 
-	std::string networkPrefix; 
+	std::pmr::string networkPrefix; 
 	int prefixLength; 
-	std::string nextHop; 
+	std::pmr::string nextHop; 
+	std::pmr::vector<std::pmr::string> nextHops;
 	int metric; 
 public: 
+	typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
 	RouterEntry(); 
-	RouterEntry(const std::string& networkPrefix, int prefixLength,const std::string& nextHop, int metric);
+	explicit RouterEntry(const allocator_type& allocator);
+	RouterEntry(const std::string& networkPrefix, int prefixLength,const std::string& nextHop, int metric,
+		const allocator_type& allocator = allocator_type());
+	RouterEntry(const RouterEntry& other) = default;
+	RouterEntry(RouterEntry&& other) = default;
+	RouterEntry(const RouterEntry& other, const allocator_type& allocator);
+	RouterEntry(RouterEntry&& other, const allocator_type& allocator);
+	RouterEntry& operator=(const RouterEntry& other) = default;
+	RouterEntry& operator=(RouterEntry&& other) = default;
 
 	std::string getNetworkPrefix() const;
 	std::string getNextHop() const;
+	std::vector<std::string> getNextHops() const;
+	std::string getNextHopList() const;
 	int getPrefixLength() const;
 	int getMetric() const;
 
 	void setNetworkPrefix(const std::string& networkPrefix); 
 	void setNextHop(const std::string& nextHop); 
+	bool addNextHop(const std::string& nextHop);
 	void setPrefixLength(int prefixLength); 
 	void setMetric(int metric);
 
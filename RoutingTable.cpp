@@ -1,9 +1,13 @@
 ﻿#include "RoutingTable.h"
+#include "IPAddress.h"
+#include "MappedFile.h"
 #include <iostream>
 #include <sstream>
+#include <string_view>
 using namespace std;
 
-RoutingTable::RoutingTable() {
+RoutingTable::RoutingTable(pmr::memory_resource* resource)
+    : routes(resource) {
 }
 
 bool RoutingTable::isEmpty() const {
@@ -14,22 +18,129 @@ size_t RoutingTable::getRouteCount() const {
     return routes.size();
 }
 
+const RoutingTable::RouteMap& RoutingTable::getRoutes() const {
+    return routes;
+}
+
 void RoutingTable::addRoute(const string& prefix, int prefixLen, const string& nextHop, int metric) {
     string key = prefix + "/" + to_string(prefixLen);
+
+    // Same prefix at the same cost: join the equal-cost next-hop group.
+    auto existing = routes.find(string_view(key));
+    if (existing != routes.end() && existing->second.getMetric() == metric) {
+        existing->second.addNextHop(nextHop);
+        return;
+    }
+
     RouterEntry entry(prefix, prefixLen, nextHop, metric);
-    routes[key] = entry;
+    if (existing != routes.end()) {
+        existing->second = entry;
+    }
+    else {
+        routes.emplace(key, entry);
+    }
 }
 
-void RoutingTable::removeRoute(const string& prefix, int prefixLen) {
-    string key = prefix + "/" + to_string(prefixLen);
+// Bulk-loads a RIB dump with one "prefix/len nextHop[,nextHop...] [metric]"
+// route per line; '#' starts a comment. The file is mapped and scanned in place.
+// Time Complexity: O(r log r) for r routes
+size_t RoutingTable::loadFromFile(const string& filename) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        cout << "Error: Cannot open route file " << filename << endl;
+        return 0;
+    }
+
+    const char* p = file.getData();
+    const char* end = p + file.getSize();
+    size_t loaded = 0;
+    size_t lineNumber = 0;
+
+    while (p < end) {
+        const char* lineEnd = p;
+        while (lineEnd < end && *lineEnd != '\n') {
+            lineEnd++;
+        }
+        lineNumber++;
+
+        const char* cursor = p;
+        p = lineEnd + 1;
+
+        while (cursor < lineEnd && (*cursor == ' ' || *cursor == '\t')) {
+            cursor++;
+        }
+        if (cursor == lineEnd || *cursor == '#' || *cursor == '\r') {
+            continue;
+        }
+
+        uint32_t prefix = 0;
+        int prefixLen = -1;
+        if (IPAddress::parse(cursor, lineEnd, prefix) && cursor < lineEnd && *cursor == '/') {
+            cursor++;
+            prefixLen = 0;
+            while (cursor < lineEnd && *cursor >= '0' && *cursor <= '9') {
+                prefixLen = prefixLen * 10 + (*cursor - '0');
+                cursor++;
+            }
+        }
+        if (prefixLen < 0 || prefixLen > 32) {
+            cout << "Warning: Skipping malformed route at line " << lineNumber << endl;
+            continue;
+        }
+
+        while (cursor < lineEnd && (*cursor == ' ' || *cursor == '\t')) {
+            cursor++;
+        }
+        const char* hopStart = cursor;
+        while (cursor < lineEnd && *cursor != ' ' && *cursor != '\t' && *cursor != '\r') {
+            cursor++;
+        }
+        if (cursor == hopStart) {
+            cout << "Warning: Skipping route without next hop at line " << lineNumber << endl;
+            continue;
+        }
+        string nextHops(hopStart, cursor);
 
-    if (routes.find(key) != routes.end()) {
-        routes.erase(key);
-        cout << "Route removed: " << key << endl;
+        while (cursor < lineEnd && (*cursor == ' ' || *cursor == '\t')) {
+            cursor++;
+        }
+        int metric = 1;
+        if (cursor < lineEnd && *cursor >= '0' && *cursor <= '9') {
+            metric = 0;
+            while (cursor < lineEnd && *cursor >= '0' && *cursor <= '9') {
+                metric = metric * 10 + (*cursor - '0');
+                cursor++;
+            }
+        }
+
+        // "A,B,C" lists equal-cost next hops for the prefix
+        string prefixText = IPAddress::toString(prefix);
+        size_t hopBegin = 0;
+        while (hopBegin <= nextHops.size()) {
+            size_t comma = nextHops.find(',', hopBegin);
+            if (comma == string::npos) {
+                comma = nextHops.size();
+            }
+            if (comma > hopBegin) {
+                addRoute(prefixText, prefixLen, nextHops.substr(hopBegin, comma - hopBegin), metric);
+            }
+            hopBegin = comma + 1;
+        }
+        loaded++;
     }
-    else {
-        cout << "Route not found: " << key << endl;
+
+    cout << "Loaded " << loaded << " routes from " << filename << endl;
+    return loaded;
+}
+
+bool RoutingTable::removeRoute(const string& prefix, int prefixLen) {
+    string key = prefix + "/" + to_string(prefixLen);
+    auto existing = routes.find(string_view(key));
+    if (existing == routes.end()) {
+        return false;
     }
+    routes.erase(existing);
+    return true;
 }
 
 void RoutingTable::displayRoutingTable() const {
@@ -43,7 +154,7 @@ void RoutingTable::displayRoutingTable() const {
     for (const auto& pair : routes) {
         const RouterEntry& entry = pair.second;
         cout << "  " << entry.getNetworkPrefix() << "/" << entry.getPrefixLength()
-            << " -> " << entry.getNextHop()
+            << " -> " << entry.getNextHopList()
             << " (Metric:" << entry.getMetric() << ")" << endl;
     }
 }
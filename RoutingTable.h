@@ -1,17 +1,26 @@
 #ifndef ROUTINGTABLE_H
 #define ROUTINGTABLE_H
+#include <functional>
 #include <map>
+#include <memory_resource>
 #include "RouterEntry.h"
+// Routes keyed by "prefix/length"; nodes, keys and entries are allocated
+// from the memory resource given at construction.
 class RoutingTable {
+public:
+	typedef std::pmr::map<std::pmr::string, RouterEntry, std::less<>> RouteMap;
+
 private:
-	std::map<std::string, RouterEntry> routes;
+	RouteMap routes;
 
 public:
-	RoutingTable();
+	RoutingTable(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 	bool isEmpty() const;
 	size_t getRouteCount() const;
+	const RouteMap& getRoutes() const;
 	void addRoute(const std::string& prefix, int prefixLen, const std::string& nextHop, int metric = 1);
-	void removeRoute(const std::string& prefix, int prefixLen);
+	size_t loadFromFile(const std::string& filename);
+	bool removeRoute(const std::string& prefix, int prefixLen);
 	void displayRoutingTable() const;
 	unsigned long ipToInt(const std::string& ip);
 	bool ipMatchesPrefix(const std::string& destIP, const RouterEntry& entry);
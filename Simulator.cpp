@@ -0,0 +1,216 @@
+#include "Simulator.h"
+#include "Clock.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+// Packets queued on the link are allocated from resource.
+Simulator::Simulator(QoService* qos, ForwardingTable* forwardingTable, pmr::memory_resource* resource)
+    : qos(qos), forwardingTable(forwardingTable), link(1e9, 0, resource), now(0), endTime(0), eventCount(0), wallTime(0),
+    nextPacketId(1), arrivals(0), droppedTTL(0), droppedNoRoute(0) {
+    for (int qosClass = 0; qosClass < 3; qosClass++) {
+        classLatency[qosClass] = 0;
+        classMaxLatency[qosClass] = 0;
+        classDelivered[qosClass] = 0;
+    }
+}
+
+// Traffic file format, "#" starts a comment:
+//   link <bandwidth Mbit/s> <propagation delay us>
+//   <source> <destination> <port> <size bytes> <process> ...   (see TrafficSource::parse)
+size_t Simulator::loadTraffic(const string& filename) {
+    ifstream input(filename);
+    if (!input.is_open()) {
+        cout << "Error: Cannot open traffic file " << filename << endl;
+        return 0;
+    }
+
+    string line;
+    size_t lineNumber = 0;
+    size_t loaded = 0;
+
+    while (getline(input, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != string::npos) {
+            line.erase(comment);
+        }
+        istringstream fields(line);
+        string first;
+        if (!(fields >> first)) {
+            continue;
+        }
+
+        if (first == "link") {
+            double megabits = 0;
+            double microseconds = 0;
+            if (!(fields >> megabits >> microseconds) || megabits <= 0 || microseconds < 0) {
+                cout << "Warning: Skipping malformed link at line " << lineNumber << endl;
+                continue;
+            }
+            setLink(Link(megabits * 1e6, static_cast<long long>(microseconds * 1000)));
+            continue;
+        }
+
+        TrafficSource source;
+        if (!TrafficSource::parse(first, fields, static_cast<unsigned>(lineNumber), source)) {
+            cout << "Warning: Skipping malformed source at line " << lineNumber << endl;
+            continue;
+        }
+        addSource(source);
+        loaded++;
+    }
+
+    cout << "Loaded " << loaded << " traffic sources from " << filename << endl;
+    return loaded;
+}
+
+void Simulator::addSource(const TrafficSource& source) {
+    sources.push_back(source);
+}
+
+void Simulator::setLink(const Link& link) {
+    this->link = link;
+}
+
+void Simulator::schedule(long long time, uint32_t type, uint32_t target) {
+    SimEvent event;
+    event.time = time;
+    event.type = type;
+    event.target = target;
+    events.push(event);
+}
+
+// Runs for duration nanoseconds of virtual time, then lets packets already
+// queued or on the wire drain.
+void Simulator::run(long long duration) {
+    endTime = now + duration;
+    for (uint32_t i = 0; i < sources.size(); i++) {
+        schedule(sources[i].nextArrival(now), PACKET_ARRIVAL, i);
+    }
+
+    long long wallStart = Clock::now();
+    while (!events.empty()) {
+        SimEvent event = events.pop();
+        now = event.time;
+        eventCount++;
+
+        if (event.type == PACKET_ARRIVAL) {
+            handleArrival(event.target);
+        }
+        else if (event.type == TRANSMIT_COMPLETE) {
+            handleTransmitComplete();
+        }
+        else {
+            handleDelivery();
+        }
+    }
+    wallTime += Clock::now() - wallStart;
+}
+
+void Simulator::handleArrival(uint32_t sourceIndex) {
+    TrafficSource& source = sources[sourceIndex];
+    packets packet = source.makePacket(nextPacketId++);
+    arrivals++;
+
+    qos->enqueuePacket(packet, now);
+    if (!link.isBusy()) {
+        startTransmission();
+    }
+
+    long long next = source.nextArrival(now);
+    if (next < endTime) {
+        schedule(next, PACKET_ARRIVAL, sourceIndex);
+    }
+}
+
+// Takes the next packet from the scheduler and puts it on the link;
+// packets that cannot be forwarded are dropped without using the link.
+void Simulator::startTransmission() {
+    while (!qos->allQueuesEmpty()) {
+        packets packet = qos->getNextPacket(now);
+
+        packet.decrementTTL();
+        if (packet.getTTL() <= 0) {
+            droppedTTL++;
+            continue;
+        }
+
+        uint32_t group = forwardingTable->lookup(packet.getDestinationAddress());
+        if (group == ForwardingTable::NO_ROUTE) {
+            droppedNoRoute++;
+            continue;
+        }
+        uint32_t flowHash = FlowTable::flowHash(packet.getSourceAddress(), packet.getDestinationAddress(),
+            static_cast<uint16_t>(packet.getPort()));
+        forwardingTable->recordForward(forwardingTable->selectMember(group, flowHash));
+
+        schedule(now + link.send(packet), TRANSMIT_COMPLETE, 0);
+        return;
+    }
+}
+
+void Simulator::handleTransmitComplete() {
+    link.finishTransmission();
+    schedule(now + link.getPropagationDelay(), PACKET_DELIVERED, 0);
+    startTransmission();
+}
+
+// End-to-end latency: arrival at the router to arrival at the far end.
+void Simulator::handleDelivery() {
+    packets packet = link.receive();
+    long long latency = now - packet.getEnqueueTime();
+    int qosClass = packet.getQosClass();
+
+    classLatency[qosClass] += latency;
+    classDelivered[qosClass]++;
+    if (latency > classMaxLatency[qosClass]) {
+        classMaxLatency[qosClass] = latency;
+    }
+}
+
+long long Simulator::getTime() const {
+    return now;
+}
+
+long long Simulator::getEventCount() const {
+    return eventCount;
+}
+
+long long Simulator::getDeliveredCount(int qosClass) const {
+    return classDelivered[qosClass];
+}
+
+long long Simulator::getAverageLatency(int qosClass) const {
+    if (classDelivered[qosClass] == 0) {
+        return 0;
+    }
+    return classLatency[qosClass] / classDelivered[qosClass];
+}
+
+void Simulator::displayResults() const {
+    const char* names[] = { "High", "Medium", "Low" };
+    double offered = 0;
+    for (const TrafficSource& source : sources) {
+        offered += source.getAverageLoad();
+    }
+
+    cout << "\n--- Simulation Results ---" << endl;
+    cout << "Simulated Time: " << Clock::toMilliseconds(now) << "ms" << endl;
+    cout << "Events: " << eventCount << " (" << (wallTime > 0 ? eventCount * 1e9 / wallTime : 0) << " events/s)" << endl;
+    cout << "Packets: " << arrivals << " arrived, " << link.getPacketsSent() << " sent, "
+        << droppedTTL << " dropped (TTL), " << droppedNoRoute << " dropped (no route)" << endl;
+    cout << "Offered Load: " << offered / link.getBandwidth() * 100 << "% of link, Utilization: "
+        << link.getUtilization(now) * 100 << "%" << endl;
+
+    cout << "Queue Delay by Class:" << endl;
+    qos->displayClassStats();
+    cout << "End-to-End Latency by Class:" << endl;
+    for (int qosClass = 0; qosClass < 3; qosClass++) {
+        cout << "  " << names[qosClass] << ": delivered " << classDelivered[qosClass]
+            << ", avg " << Clock::toMilliseconds(getAverageLatency(qosClass)) << "ms"
+            << ", max " << Clock::toMilliseconds(classMaxLatency[qosClass]) << "ms" << endl;
+    }
+}
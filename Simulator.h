@@ -0,0 +1,64 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "EventQueue.h"
+#include "Link.h"
+#include "TrafficSource.h"
+#include "qoservice.h"
+#include "ForwardingTable.h"
+
+// Discrete-event simulation of one router: traffic sources feed QoService,
+// the scheduler drains it onto a single egress link, and packets are
+// delivered after serialization and propagation. Time is virtual
+// (nanoseconds since the start of the run) and only advances from event to
+// event, so queueing delay reflects offered load, link rate and burstiness.
+class Simulator {
+public:
+    enum EventType { PACKET_ARRIVAL, TRANSMIT_COMPLETE, PACKET_DELIVERED };
+
+    Simulator(QoService* qos, ForwardingTable* forwardingTable,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    size_t loadTraffic(const std::string& filename);
+    void addSource(const TrafficSource& source);
+    void setLink(const Link& link);
+
+    void run(long long duration);
+
+    long long getTime() const;
+    long long getEventCount() const;
+    long long getDeliveredCount(int qosClass) const;
+    long long getAverageLatency(int qosClass) const;
+    void displayResults() const;
+
+private:
+    QoService* qos;
+    ForwardingTable* forwardingTable;
+    EventQueue events;
+    std::vector<TrafficSource> sources;
+    Link link;
+
+    long long now;
+    long long endTime;
+    long long eventCount;
+    long long wallTime;
+    int nextPacketId;
+
+    long long arrivals;
+    long long droppedTTL;
+    long long droppedNoRoute;
+    long long classLatency[3];
+    long long classMaxLatency[3];
+    long long classDelivered[3];
+
+    void schedule(long long time, uint32_t type, uint32_t target);
+    void handleArrival(uint32_t sourceIndex);
+    void startTransmission();
+    void handleTransmitComplete();
+    void handleDelivery();
+};
+
+#endif
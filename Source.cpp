@@ -1,6 +1,47 @@
 ﻿#include "RouterDriver.h"
+#include "Benchmark.h"
+#include <cstdlib>
+#include <string>
+#include <thread>
 
-int main() {
-    RouterDriver("file.txt", 10).run();
+int main(int argc, char* argv[]) {
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--bench") {
+        Benchmark::runAll();
+        return 0;
+    }
+
+    RouterDriver driver("file.txt", 10);
+    driver.setRouteFile("routes.txt");
+    driver.setFibSnapshot("fib.bin");
+    driver.setUpdateFile("updates.txt");
+    driver.setRuleFile("qos_rules.txt");
+    driver.setTrafficFile("traffic.txt");
+
+    if (mode == "--simulate") {
+        double seconds = argc > 2 ? std::atof(argv[2]) : 10.0;
+        driver.runSimulation(static_cast<long long>(seconds * 1e9));
+        return 0;
+    }
+    if (mode == "--topology" && argc > 2) {
+        double seconds = argc > 3 ? std::atof(argv[3]) : 1.0;
+        int threads = argc > 4 ? std::atoi(argv[4]) : static_cast<int>(std::thread::hardware_concurrency());
+        driver.runTopology(argv[2], static_cast<long long>(seconds * 1e9), threads > 0 ? threads : 1);
+        return 0;
+    }
+
+    if (mode == "--serve" && argc > 3) {
+        double seconds = argc > 4 ? std::atof(argv[4]) : 10.0;
+        driver.runSocket(argv[2], argv[3], static_cast<long long>(seconds * 1e9));
+        return 0;
+    }
+    if (mode == "--generate" && argc > 3) {
+        double seconds = argc > 4 ? std::atof(argv[4]) : 5.0;
+        double rate = argc > 5 ? std::atof(argv[5]) : 0.0;
+        driver.runGenerator(argv[2], argv[3], static_cast<long long>(seconds * 1e9), rate);
+        return 0;
+    }
+
+    driver.run();
     return 0;
-}
\ No newline at end of file
+}
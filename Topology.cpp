@@ -0,0 +1,361 @@
+#include "Topology.h"
+#include "IPAddress.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+
+using namespace std;
+
+const char* const Topology::LOCAL_HOP = "local";
+
+Topology::Router::Router()
+    : prefix(0), prefixLength(0), forwardingTable(ROUTER_INDEX_BITS) {
+}
+
+Topology::Port::Port(uint32_t router, uint32_t neighbor, const Link& link, int queueSize)
+    : router(router), neighbor(neighbor), link(link), qos(queueSize) {
+}
+
+Topology::Port::Port(const Port& other, pmr::memory_resource* resource)
+    : router(other.router), neighbor(other.neighbor), link(other.link, resource), qos(other.qos, resource) {
+}
+
+Topology::Topology(int queueSize)
+    : queueSize(queueSize), shortestPaths(false) {
+}
+
+Topology::~Topology() {
+    for (Router* router : routers) {
+        delete router;
+    }
+    for (Port* port : ports) {
+        delete port;
+    }
+}
+
+bool Topology::parsePrefix(const string& text, uint32_t& prefix, int& prefixLength) {
+    size_t slash = text.find('/');
+    if (slash == string::npos || !IPAddress::parse(text.substr(0, slash), prefix)) {
+        return false;
+    }
+    prefixLength = atoi(text.c_str() + slash + 1);
+    if (prefixLength < 0 || prefixLength > 32) {
+        return false;
+    }
+    prefix &= IPAddress::prefixMask(prefixLength);
+    return true;
+}
+
+// Topology file format, "#" starts a comment:
+//   router <name> <prefix>/<len>
+//   link <router> <router> <bandwidth Mbit/s> <propagation delay us>
+//   route <router> <prefix>/<len> <next hop>[,<next hop>...] [metric]
+//   routing shortest-path
+//   traffic <router> <source> <destination> <port> <size bytes> <process> ...
+// Links are bidirectional. "routing shortest-path" fills in hop-count
+// routes (with ECMP) to every router's prefix wherever no static route for
+// that prefix was given.
+size_t Topology::loadFromFile(const string& filename) {
+    ifstream input(filename);
+    if (!input.is_open()) {
+        cout << "Error: Cannot open topology file " << filename << endl;
+        return 0;
+    }
+
+    string line;
+    size_t lineNumber = 0;
+
+    while (getline(input, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != string::npos) {
+            line.erase(comment);
+        }
+        istringstream fields(line);
+        string keyword;
+        if (!(fields >> keyword)) {
+            continue;
+        }
+
+        if (keyword == "router") {
+            string name;
+            string prefixText;
+            uint32_t prefix = 0;
+            int prefixLength = 0;
+            if (!(fields >> name >> prefixText) || !parsePrefix(prefixText, prefix, prefixLength) ||
+                findRouter(name) != NO_ROUTER) {
+                cout << "Warning: Skipping malformed router at line " << lineNumber << endl;
+                continue;
+            }
+            addRouter(name, prefix, prefixLength);
+        }
+        else if (keyword == "link") {
+            string first;
+            string second;
+            double megabits = 0;
+            double microseconds = 0;
+            if (!(fields >> first >> second >> megabits >> microseconds) || megabits <= 0 || microseconds < 0 ||
+                !addLink(findRouter(first), findRouter(second), megabits * 1e6, static_cast<long long>(microseconds * 1000))) {
+                cout << "Warning: Skipping malformed link at line " << lineNumber << endl;
+            }
+        }
+        else if (keyword == "route") {
+            string name;
+            string prefixText;
+            string nextHops;
+            int metric = 1;
+            uint32_t prefix = 0;
+            int prefixLength = 0;
+            uint32_t router = NO_ROUTER;
+            if (!(fields >> name >> prefixText >> nextHops) || !parsePrefix(prefixText, prefix, prefixLength) ||
+                (router = findRouter(name)) == NO_ROUTER) {
+                cout << "Warning: Skipping malformed route at line " << lineNumber << endl;
+                continue;
+            }
+            fields >> metric;
+
+            size_t hopBegin = 0;
+            while (hopBegin <= nextHops.size()) {
+                size_t comma = nextHops.find(',', hopBegin);
+                if (comma == string::npos) {
+                    comma = nextHops.size();
+                }
+                if (comma > hopBegin) {
+                    addRoute(router, prefix, prefixLength, nextHops.substr(hopBegin, comma - hopBegin), metric);
+                }
+                hopBegin = comma + 1;
+            }
+        }
+        else if (keyword == "routing") {
+            string mode;
+            if (!(fields >> mode) || mode != "shortest-path") {
+                cout << "Warning: Skipping unknown routing mode at line " << lineNumber << endl;
+                continue;
+            }
+            shortestPaths = true;
+        }
+        else if (keyword == "traffic") {
+            string name;
+            string source;
+            uint32_t router = NO_ROUTER;
+            TrafficSource traffic;
+            if (!(fields >> name >> source) || (router = findRouter(name)) == NO_ROUTER ||
+                !TrafficSource::parse(source, fields, static_cast<unsigned>(lineNumber), traffic)) {
+                cout << "Warning: Skipping malformed traffic at line " << lineNumber << endl;
+                continue;
+            }
+            addSource(router, traffic);
+        }
+        else {
+            cout << "Warning: Skipping unknown entry at line " << lineNumber << endl;
+        }
+    }
+
+    cout << "Loaded " << routers.size() << " routers, " << ports.size() / 2 << " links and "
+        << getSourceCount() << " traffic sources from " << filename << endl;
+    return routers.size();
+}
+
+// Builds a tree of routerCount routers where router i hangs off router
+// (i - 1) / fanout, each owning 10.x.y.0/24 with x.y = i. Every router
+// routes its descendants' prefixes towards the right child and everything
+// else to its parent, so routes total O(n * depth).
+void Topology::generateTree(size_t routerCount, int fanout, double bandwidth, long long propagationDelay) {
+    if (routerCount > 65536) {
+        routerCount = 65536;
+    }
+    if (fanout < 1) {
+        fanout = 1;
+    }
+
+    uint32_t base = static_cast<uint32_t>(routers.size());
+    for (uint32_t i = 0; i < routerCount; i++) {
+        addRouter("R" + to_string(i), 0x0A000000u | (i << 8), 24);
+        if (i > 0) {
+            uint32_t parent = (i - 1) / fanout;
+            addLink(base + parent, base + i, bandwidth, propagationDelay);
+            addRoute(base + i, 0, 0, routers[base + parent]->name);
+        }
+    }
+
+    for (uint32_t i = 1; i < routerCount; i++) {
+        uint32_t child = i;
+        while (child > 0) {
+            uint32_t parent = (child - 1) / fanout;
+            addRoute(base + parent, routers[base + i]->prefix, 24, routers[base + child]->name);
+            child = parent;
+        }
+    }
+}
+
+uint32_t Topology::addRouter(const string& name, uint32_t prefix, int prefixLength) {
+    Router* router = new Router();
+    router->name = name;
+    router->prefix = prefix & IPAddress::prefixMask(prefixLength);
+    router->prefixLength = prefixLength;
+
+    uint32_t index = static_cast<uint32_t>(routers.size());
+    routers.push_back(router);
+    routerIndex[name] = index;
+    return index;
+}
+
+bool Topology::addLink(uint32_t first, uint32_t second, double bandwidth, long long propagationDelay) {
+    if (first >= routers.size() || second >= routers.size() || first == second) {
+        return false;
+    }
+
+    Link link(bandwidth, propagationDelay);
+    routers[first]->ports.push_back(static_cast<uint32_t>(ports.size()));
+    ports.push_back(new Port(first, second, link, queueSize));
+    routers[second]->ports.push_back(static_cast<uint32_t>(ports.size()));
+    ports.push_back(new Port(second, first, link, queueSize));
+    return true;
+}
+
+void Topology::addRoute(uint32_t router, uint32_t prefix, int prefixLength, const string& nextHop, int metric) {
+    routers[router]->routingTable.addRoute(IPAddress::toString(prefix), prefixLength, nextHop, metric);
+}
+
+void Topology::addSource(uint32_t router, const TrafficSource& source) {
+    routers[router]->sources.push_back(source);
+}
+
+// Breadth-first search from every router; each neighbor one hop closer to
+// the destination joins the ECMP group. Routers that already have a static
+// route for the destination prefix keep it.
+// Time Complexity: O(n * (n + m)) for n routers and m links
+void Topology::computeShortestPathRoutes() {
+    const uint32_t UNREACHED = 0xFFFFFFFFu;
+    vector<uint32_t> distance(routers.size());
+    vector<uint32_t> frontier;
+
+    for (uint32_t destination = 0; destination < routers.size(); destination++) {
+        distance.assign(routers.size(), UNREACHED);
+        distance[destination] = 0;
+        frontier.assign(1, destination);
+
+        for (size_t next = 0; next < frontier.size(); next++) {
+            uint32_t router = frontier[next];
+            for (uint32_t port : routers[router]->ports) {
+                uint32_t neighbor = ports[port]->neighbor;
+                if (distance[neighbor] == UNREACHED) {
+                    distance[neighbor] = distance[router] + 1;
+                    frontier.push_back(neighbor);
+                }
+            }
+        }
+
+        const Router& target = *routers[destination];
+        string key = IPAddress::toString(target.prefix) + "/" + to_string(target.prefixLength);
+        for (uint32_t router : frontier) {
+            if (router == destination || routers[router]->routingTable.getRoutes().count(string_view(key)) > 0) {
+                continue;
+            }
+            for (uint32_t port : routers[router]->ports) {
+                uint32_t neighbor = ports[port]->neighbor;
+                if (distance[neighbor] + 1 == distance[router]) {
+                    addRoute(router, target.prefix, target.prefixLength, routers[neighbor]->name,
+                        static_cast<int>(distance[router]));
+                }
+            }
+        }
+    }
+}
+
+// Adds each router's own prefix as a local route, compiles the FIBs and
+// maps every FIB next hop to the port that reaches it. Next hops that are
+// not neighbors map to NO_PORT and drop as unroutable.
+void Topology::build(const PacketClassifier* classifier) {
+    if (shortestPaths) {
+        computeShortestPathRoutes();
+    }
+
+    for (Router* router : routers) {
+        router->routingTable.addRoute(IPAddress::toString(router->prefix), router->prefixLength, LOCAL_HOP, 0);
+        router->forwardingTable.build(router->routingTable);
+
+        router->hopPorts.assign(router->forwardingTable.getNextHopCount(), static_cast<uint32_t>(NO_PORT));
+        for (uint32_t hop = 0; hop < router->hopPorts.size(); hop++) {
+            string nextHop = router->forwardingTable.getNextHop(hop);
+            if (nextHop == LOCAL_HOP) {
+                router->hopPorts[hop] = LOCAL_PORT;
+                continue;
+            }
+            uint32_t neighbor = findRouter(nextHop);
+            for (uint32_t port : router->ports) {
+                if (ports[port]->neighbor == neighbor) {
+                    router->hopPorts[hop] = port;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (Port* port : ports) {
+        port->qos.setClassifier(classifier);
+    }
+}
+
+// Moves the router's egress queues and links, with anything queued on
+// them, to the given memory resource, e.g. the pool of the thread that
+// simulates the router.
+void Topology::setMemoryResource(uint32_t router, pmr::memory_resource* resource) {
+    for (uint32_t port : routers[router]->ports) {
+        Port* rebound = new Port(*ports[port], resource);
+        delete ports[port];
+        ports[port] = rebound;
+    }
+}
+
+uint32_t Topology::findRouter(const string& name) const {
+    auto it = routerIndex.find(name);
+    return it == routerIndex.end() ? NO_ROUTER : it->second;
+}
+
+size_t Topology::getRouterCount() const {
+    return routers.size();
+}
+
+Topology::Router& Topology::getRouter(uint32_t router) {
+    return *routers[router];
+}
+
+const Topology::Router& Topology::getRouter(uint32_t router) const {
+    return *routers[router];
+}
+
+size_t Topology::getPortCount() const {
+    return ports.size();
+}
+
+Topology::Port& Topology::getPort(uint32_t port) {
+    return *ports[port];
+}
+
+const Topology::Port& Topology::getPort(uint32_t port) const {
+    return *ports[port];
+}
+
+size_t Topology::getRouteCount() const {
+    size_t count = 0;
+    for (const Router* router : routers) {
+        count += router->routingTable.getRouteCount();
+    }
+    return count;
+}
+
+size_t Topology::getSourceCount() const {
+    size_t count = 0;
+    for (const Router* router : routers) {
+        count += router->sources.size();
+    }
+    return count;
+}
+
+void Topology::displaySummary() const {
+    cout << "Topology: " << routers.size() << " routers, " << ports.size() / 2 << " links, "
+        << getRouteCount() << " routes, " << getSourceCount() << " traffic sources" << endl;
+}
@@ -0,0 +1,92 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ForwardingTable.h"
+#include "Link.h"
+#include "PacketClassifier.h"
+#include "RoutingTable.h"
+#include "TrafficSource.h"
+#include "qoservice.h"
+
+// Graph of routers for the network simulation. Every router has its own
+// RoutingTable and ForwardingTable and one egress port per neighbor; a port
+// is a Link fed by its own QoService. Next hops in a router's routes are
+// neighbor names, or LOCAL_HOP for addresses the router delivers itself.
+class Topology {
+public:
+    static const uint32_t NO_ROUTER = 0xFFFFFFFFu;
+    static const uint32_t NO_PORT = 0xFFFFFFFFu;
+    static const uint32_t LOCAL_PORT = 0xFFFFFFFEu;
+    static const char* const LOCAL_HOP;
+
+    struct Port {
+        uint32_t router;
+        uint32_t neighbor;
+        Link link;
+        QoService qos;
+
+        Port(uint32_t router, uint32_t neighbor, const Link& link, int queueSize);
+        Port(const Port& other, std::pmr::memory_resource* resource);
+    };
+
+    struct Router {
+        std::string name;
+        uint32_t prefix;
+        int prefixLength;
+        RoutingTable routingTable;
+        ForwardingTable forwardingTable;
+        std::vector<uint32_t> ports;
+        std::vector<uint32_t> hopPorts;    // FIB next-hop index -> port
+        std::vector<TrafficSource> sources;
+
+        Router();
+    };
+
+    Topology(int queueSize = 256);
+    ~Topology();
+
+    Topology(const Topology&) = delete;
+    Topology& operator=(const Topology&) = delete;
+
+    size_t loadFromFile(const std::string& filename);
+    void generateTree(size_t routerCount, int fanout, double bandwidth, long long propagationDelay);
+
+    uint32_t addRouter(const std::string& name, uint32_t prefix, int prefixLength);
+    bool addLink(uint32_t first, uint32_t second, double bandwidth, long long propagationDelay);
+    void addRoute(uint32_t router, uint32_t prefix, int prefixLength, const std::string& nextHop, int metric = 1);
+    void addSource(uint32_t router, const TrafficSource& source);
+    void computeShortestPathRoutes();
+    void build(const PacketClassifier* classifier);
+    void setMemoryResource(uint32_t router, std::pmr::memory_resource* resource);
+
+    uint32_t findRouter(const std::string& name) const;
+    size_t getRouterCount() const;
+    Router& getRouter(uint32_t router);
+    const Router& getRouter(uint32_t router) const;
+    size_t getPortCount() const;
+    Port& getPort(uint32_t port);
+    const Port& getPort(uint32_t port) const;
+    size_t getRouteCount() const;
+    size_t getSourceCount() const;
+    void displaySummary() const;
+
+private:
+    // Per-router FIBs are small, so a 256-entry index is enough
+    static const int ROUTER_INDEX_BITS = 8;
+
+    int queueSize;
+    bool shortestPaths;
+    std::vector<Router*> routers;
+    std::vector<Port*> ports;
+    std::unordered_map<std::string, uint32_t> routerIndex;
+
+    static bool parsePrefix(const std::string& text, uint32_t& prefix, int& prefixLength);
+};
+
+#endif
@@ -1,54 +1,73 @@
 #include "TraceEntry.h"
-#include <ctime>
+#include "Clock.h"
 #include <iostream> 
 using namespace std; 
 
-TraceEntry::TraceEntry() {
+TraceEntry::TraceEntry()
+    : TraceEntry(allocator_type()) {
+};
+
+TraceEntry::TraceEntry(const allocator_type& allocator)
+    : routerID(allocator), action(allocator), nextHop(allocator) {
     routerID = ""; 
     action = ""; 
     queueDelay = 0; 
     remainingTTL = 0;
     nextHop = "";
-	timestamp = time(nullptr);
+	timestamp = Clock::now();
 }; 
 
 
 TraceEntry::TraceEntry(const string& routerID, const string& action,
-    int queueDelay, int remainingTTL, const string& nextHop) {
+    long long queueDelay, int remainingTTL, const string& nextHop, const allocator_type& allocator)
+    : routerID(allocator), action(allocator), nextHop(allocator) {
 	this->routerID = routerID;
     this->action = action; 
     this->queueDelay = queueDelay; 
     this->remainingTTL = remainingTTL; 
     this->nextHop = nextHop; 
-	timestamp = time(nullptr);
+	timestamp = Clock::now();
 }; 
 
+TraceEntry::TraceEntry(const TraceEntry& other, const allocator_type& allocator)
+    : routerID(other.routerID, allocator), timestamp(other.timestamp), action(other.action, allocator),
+    queueDelay(other.queueDelay), remainingTTL(other.remainingTTL), nextHop(other.nextHop, allocator) {
+};
+
+TraceEntry::TraceEntry(TraceEntry&& other, const allocator_type& allocator)
+    : routerID(move(other.routerID), allocator), timestamp(other.timestamp), action(move(other.action), allocator),
+    queueDelay(other.queueDelay), remainingTTL(other.remainingTTL), nextHop(move(other.nextHop), allocator) {
+};
+
 string TraceEntry::getRouterID() const {
-    return routerID; 
+    return string(routerID.data(), routerID.size()); 
 };
-time_t TraceEntry::getTimestamp() const {
+long long TraceEntry::getTimestamp() const {
     return timestamp; 
 };
 string TraceEntry::getAction() const {
-    return action; 
+    return string(action.data(), action.size()); 
 };
-int TraceEntry::getQueueDelay() const {
+long long TraceEntry::getQueueDelay() const {
     return queueDelay; 
 };
 int TraceEntry::getRemainingTTL() const {
     return remainingTTL; 
 };
 string TraceEntry::getNextHop() const {
-    return nextHop;; 
+    return string(nextHop.data(), nextHop.size()); 
 };
 
 void TraceEntry::setRouterID(const string& routerID) {
     this->routerID = routerID;
 };
+void TraceEntry::setTimestamp(long long timestamp) {
+    this->timestamp = timestamp;
+};
 void TraceEntry::setAction(const string& action) {
     this->action = action; 
 };
-void TraceEntry::setQueueDelay(int queueDelay) {
+void TraceEntry::setQueueDelay(long long queueDelay) {
     this->queueDelay = queueDelay;
 };
 void TraceEntry::setRemainingTTL(int remainingTTL) {
@@ -60,9 +79,9 @@ void TraceEntry::setNextHop(const string& nextHop) {
 
 void TraceEntry::display() const {
 	cout << "Router ID: " << routerID << endl;
-	cout << "Timestamp: " << timestamp << endl;
+	cout << "Timestamp: " << timestamp << " ns" << endl;
 	cout << "Action: " << action << endl;
-	cout << "Queue Delay: " << queueDelay << " ms" << endl; 
+	cout << "Queue Delay: " << Clock::toMilliseconds(queueDelay) << " ms" << endl; 
 	cout << "Remaining TTL: " << remainingTTL << endl;
 	cout << "Next Hop: " << nextHop << endl;
 
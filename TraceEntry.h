@@ -1,30 +1,46 @@
 #ifndef TRACEENTRY_H 
 #define TRACEENTRY_H
+#include <memory_resource>
 #include <string>
 
+// Timestamps and queue delays are in nanoseconds (see Clock); simulations
+// overwrite the timestamp with virtual time. Allocator-aware, so entries in
+// a PacketHistory use the history's memory resource.
+
 class TraceEntry {
 private:
-    std::string routerID;
-    time_t timestamp;
-    std::string action;
-    int queueDelay;
+    std::pmr::string routerID;
+    long long timestamp;
+    std::pmr::string action;
+    long long queueDelay;
     int remainingTTL;
-    std::string nextHop;
+    std::pmr::string nextHop;
 public:
+    typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
     TraceEntry();
+    explicit TraceEntry(const allocator_type& allocator);
     TraceEntry(const std::string& routerID, const std::string& action,
-        int queueDelay, int remainingTTL, const std::string& nextHop = "");
+        long long queueDelay, int remainingTTL, const std::string& nextHop = "",
+        const allocator_type& allocator = allocator_type());
+    TraceEntry(const TraceEntry& other) = default;
+    TraceEntry(TraceEntry&& other) = default;
+    TraceEntry(const TraceEntry& other, const allocator_type& allocator);
+    TraceEntry(TraceEntry&& other, const allocator_type& allocator);
+    TraceEntry& operator=(const TraceEntry& other) = default;
+    TraceEntry& operator=(TraceEntry&& other) = default;
 
     std::string getRouterID() const;
-    time_t getTimestamp() const;
+    long long getTimestamp() const;
     std::string getAction() const;
-    int getQueueDelay() const;
+    long long getQueueDelay() const;
     int getRemainingTTL() const;
     std::string getNextHop() const;
 
     void setRouterID(const std::string& routerID);
+    void setTimestamp(long long timestamp);
     void setAction(const std::string& action);
-    void setQueueDelay(int delay);
+    void setQueueDelay(long long delay);
     void setRemainingTTL(int ttl);
     void setNextHop(const std::string& nextHop);   
     void display() const;
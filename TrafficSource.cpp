@@ -0,0 +1,97 @@
+#include "TrafficSource.h"
+
+using namespace std;
+
+TrafficSource::TrafficSource()
+    : port(0), size(1500), process(CONSTANT_RATE), rate(1), meanOnTime(0), meanOffTime(0), burstEnd(0) {
+}
+
+TrafficSource::TrafficSource(const string& source, const string& destination, int port, int size,
+    Process process, double rate, unsigned seed)
+    : source(source), destination(destination), port(port), size(size), process(process), rate(rate),
+    meanOnTime(0), meanOffTime(0), burstEnd(0), rng(seed) {
+}
+
+// Reads the rest of a source line after its source address:
+//   <destination> <port> <size bytes> cbr|poisson <packets/s>
+//   <destination> <port> <size bytes> onoff <peak packets/s> <mean on ms> <mean off ms>
+bool TrafficSource::parse(const string& source, istream& fields, unsigned seed, TrafficSource& result) {
+    string destination;
+    string processName;
+    int port = 0;
+    int size = 0;
+    double rate = 0;
+    if (!(fields >> destination >> port >> size >> processName >> rate) || size <= 0 || rate <= 0) {
+        return false;
+    }
+
+    if (processName == "cbr") {
+        result = TrafficSource(source, destination, port, size, CONSTANT_RATE, rate, seed);
+        return true;
+    }
+    if (processName == "poisson") {
+        result = TrafficSource(source, destination, port, size, POISSON, rate, seed);
+        return true;
+    }
+    if (processName == "onoff") {
+        double onMillis = 0;
+        double offMillis = 0;
+        if (!(fields >> onMillis >> offMillis) || onMillis <= 0 || offMillis <= 0) {
+            return false;
+        }
+        result = TrafficSource(source, destination, port, size, ON_OFF, rate, seed);
+        result.setOnOff(static_cast<long long>(onMillis * 1e6), static_cast<long long>(offMillis * 1e6));
+        return true;
+    }
+    return false;
+}
+
+void TrafficSource::setOnOff(long long meanOnTime, long long meanOffTime) {
+    this->meanOnTime = meanOnTime;
+    this->meanOffTime = meanOffTime;
+    burstEnd = exponential(static_cast<double>(meanOnTime));
+}
+
+long long TrafficSource::exponential(double mean) {
+    exponential_distribution<double> distribution(1.0 / mean);
+    return static_cast<long long>(distribution(rng));
+}
+
+// Returns the time of the packet after one sent at now.
+long long TrafficSource::nextArrival(long long now) {
+    double gap = 1e9 / rate;
+
+    if (process == POISSON) {
+        return now + 1 + exponential(gap);
+    }
+
+    long long next = now + static_cast<long long>(gap);
+    if (process == ON_OFF) {
+        // Past the end of the burst: skip the silence, start the next burst
+        while (next >= burstEnd) {
+            long long silenceEnd = burstEnd + exponential(static_cast<double>(meanOffTime));
+            burstEnd = silenceEnd + 1 + exponential(static_cast<double>(meanOnTime));
+            next = silenceEnd;
+        }
+    }
+    return next;
+}
+
+packets TrafficSource::makePacket(int id) const {
+    packets packet(id, source, destination, port, 64);
+    packet.setSize(size);
+    return packet;
+}
+
+double TrafficSource::getRate() const {
+    return rate;
+}
+
+// Long-run offered load in bits per second.
+double TrafficSource::getAverageLoad() const {
+    double bits = rate * size * 8.0;
+    if (process == ON_OFF && meanOnTime + meanOffTime > 0) {
+        bits = bits * meanOnTime / (meanOnTime + meanOffTime);
+    }
+    return bits;
+}
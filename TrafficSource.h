@@ -0,0 +1,47 @@
+#ifndef TRAFFICSOURCE_H
+#define TRAFFICSOURCE_H
+
+#include <istream>
+#include <random>
+#include <string>
+#include "packets.h"
+
+// Packet arrival process for the simulator. All times are virtual
+// nanoseconds.
+//   CONSTANT_RATE  fixed gap of 1/rate
+//   POISSON        exponential gaps with mean 1/rate
+//   ON_OFF         bursts at the peak rate for an exponential on-period,
+//                  then silence for an exponential off-period
+class TrafficSource {
+public:
+    enum Process { CONSTANT_RATE, POISSON, ON_OFF };
+
+    TrafficSource();
+    TrafficSource(const std::string& source, const std::string& destination, int port, int size,
+        Process process, double rate, unsigned seed);
+
+    static bool parse(const std::string& source, std::istream& fields, unsigned seed, TrafficSource& result);
+
+    void setOnOff(long long meanOnTime, long long meanOffTime);
+    long long nextArrival(long long now);
+    packets makePacket(int id) const;
+
+    double getRate() const;
+    double getAverageLoad() const;
+
+private:
+    std::string source;
+    std::string destination;
+    int port;
+    int size;
+    Process process;
+    double rate;
+    long long meanOnTime;
+    long long meanOffTime;
+    long long burstEnd;
+    std::mt19937_64 rng;
+
+    long long exponential(double mean);
+};
+
+#endif
@@ -1,107 +1,178 @@
 #include "qoservice.h"
+#include "Clock.h"
+#include "PacketParser.h"
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <vector>
 using namespace std;
 
-QoService::QoService(int maxSize)
-    : highCount(0), mediumCount(0), lowCount(0), maxQueueSize(maxSize), forwardedStatus(false) {
+QoService::QoService(int maxSize, pmr::memory_resource* resource)
+    : highPriorityQueue(pmr::polymorphic_allocator<packets>(resource)),
+    mediumPriorityQueue(pmr::polymorphic_allocator<packets>(resource)),
+    lowPriorityQueue(pmr::polymorphic_allocator<packets>(resource)), highCount(0), mediumCount(0), lowCount(0), maxQueueSize(maxSize), forwardedStatus(false),
+    totalQueueDelay(0), dequeuedCount(0), flowTable(nullptr), classifier(nullptr) {
+    for (int qosClass = 0; qosClass < 3; qosClass++) {
+        classQueueDelay[qosClass] = 0;
+        classMaxQueueDelay[qosClass] = 0;
+        classDequeued[qosClass] = 0;
+        classDropped[qosClass] = 0;
+    }
 }
 
-vector<packets> QoService::readPacketsFromFile(const string& filename) {
-    vector<packets> packetList;
-    ifstream file(filename);
+// Copies the queues and statistics into the given memory resource.
+QoService::QoService(const QoService& other, pmr::memory_resource* resource)
+    : highPriorityQueue(other.highPriorityQueue, pmr::polymorphic_allocator<packets>(resource)),
+    mediumPriorityQueue(other.mediumPriorityQueue, pmr::polymorphic_allocator<packets>(resource)),
+    lowPriorityQueue(other.lowPriorityQueue, pmr::polymorphic_allocator<packets>(resource)),
+    highCount(other.highCount), mediumCount(other.mediumCount), lowCount(other.lowCount),
+    maxQueueSize(other.maxQueueSize), forwardedStatus(other.forwardedStatus),
+    totalQueueDelay(other.totalQueueDelay), dequeuedCount(other.dequeuedCount),
+    flowTable(other.flowTable), classifier(other.classifier) {
+    for (int qosClass = 0; qosClass < 3; qosClass++) {
+        classQueueDelay[qosClass] = other.classQueueDelay[qosClass];
+        classMaxQueueDelay[qosClass] = other.classMaxQueueDelay[qosClass];
+        classDequeued[qosClass] = other.classDequeued[qosClass];
+        classDropped[qosClass] = other.classDropped[qosClass];
+    }
+}
 
-    if (!file.is_open()) {
-        cout << "Error: Cannot open file " << filename << endl;
-        return packetList;
+void QoService::setFlowTable(FlowTable* table) {
+    flowTable = table;
+}
+
+void QoService::setClassifier(const PacketClassifier* rules) {
+    classifier = rules;
+}
+
+int QoService::getMaxQueueSize() const {
+    return maxQueueSize;
+}
+
+int QoService::classifyPort(int port) const {
+    if (port >= 0 && port <= 1023) {
+        return HIGH_PRIORITY;
+    }
+    else if (port >= 1024 && port <= 49151) {
+        return MEDIUM_PRIORITY;
     }
+    return LOW_PRIORITY;
+}
 
-    string line;
-    getline(file, line); // Skip header
-
-    while (getline(file, line)) {
-        stringstream ss(line);
-        string token;
-        vector<string> tokens;
-
-        while (getline(ss, token, ',')) {
-            size_t start = token.find_first_not_of(" \t\r\n");
-            size_t end = token.find_last_not_of(" \t\r\n");
-            if (start != string::npos && end != string::npos) {
-                tokens.push_back(token.substr(start, end - start + 1));
-            }
-            else if (start != string::npos) {
-                tokens.push_back(token.substr(start));
-            }
-            else {
-                tokens.push_back("");
-            }
+// Rule-based class when a classifier is attached, port ranges otherwise or
+// when no rule matches.
+int QoService::classifyPacket(const packets& packet) const {
+    if (classifier != nullptr) {
+        int qosClass = classifier->classify(packet.getSourceAddress(), packet.getDestinationAddress(), packet.getPort());
+        if (qosClass != PacketClassifier::NO_MATCH) {
+            return qosClass;
         }
+    }
+    return classifyPort(packet.getPort());
+}
 
-        if (tokens.size() >= 5) {
-            int id = stoi(tokens[0]);
-            string source = tokens[1];
-            string destination = tokens[2];
-            int port = stoi(tokens[3]);
-            int ttl = stoi(tokens[4]);
+// With a flow table attached, a packet's class is computed once per flow and
+// the packet remembers its flow slot so forwarding does not probe again.
+int QoService::classifyFlow(packets& packet, long long now) {
+    if (flowTable == nullptr) {
+        return classifyPacket(packet);
+    }
 
-            packets packet(id, source, destination, port, ttl);
-            packetList.push_back(packet);
-        }
+    uint16_t port = static_cast<uint16_t>(packet.getPort());
+    uint32_t hash = FlowTable::flowHash(packet.getSourceAddress(), packet.getDestinationAddress(), port);
+    uint32_t slot = flowTable->acquire(packet.getSourceAddress(), packet.getDestinationAddress(),
+        port, hash, now);
+    flowTable->recordPacket(slot, now);
+    packet.setFlowSlot(slot);
+
+    int qosClass = flowTable->getQosClass(slot);
+    if (qosClass == FlowTable::UNCLASSIFIED) {
+        qosClass = classifyPacket(packet);
+        flowTable->setQosClass(slot, qosClass);
     }
+    return qosClass;
+}
 
-    file.close();
-    cout << "Loaded " << packetList.size() << " packets" << endl;
+// Parsed across all cores; see PacketParser.
+vector<packets> QoService::readPacketsFromFile(const string& filename) {
+    vector<packets> packetList;
+    PacketParser parser;
+    if (parser.parseFile(filename, packetList) == 0) {
+        cout << "Loaded 0 packets" << endl;
+        return packetList;
+    }
+
+    cout << "Loaded " << packetList.size() << " packets (" << parser.getChunkCount() << " chunks, "
+        << Clock::toMilliseconds(parser.getParseTime()) << "ms)" << endl;
     return packetList;
 }
 
 void QoService::classifyPackets(const vector<packets>& packetVec) {
     for (size_t i = 0; i < packetVec.size(); i++) {
         packets packet = packetVec[i];
-        int port = packet.getPort();
-
-        if (port >= 0 && port <= 1023) {
-            packet.setPriority("High");
-            if (highCount < maxQueueSize) {
-                highPriorityQueue.push(packet);
-                highCount++;
-            }
+        enqueuePacket(packet, Clock::now());
+    }
+}
+
+// Classifies one packet and queues it, stamped with now (wall clock or
+// simulation time). Returns false when the class queue is full (tail drop).
+bool QoService::enqueuePacket(packets& packet, long long now) {
+    int qosClass = classifyFlow(packet, now);
+    packet.setQosClass(qosClass);
+
+    if (qosClass == HIGH_PRIORITY) {
+        packet.setPriority("High");
+        if (highCount < maxQueueSize) {
+            packet.markEnqueued(now);
+            highPriorityQueue.push(packet);
+            highCount++;
+            return true;
         }
-        else if (port >= 1024 && port <= 49151) {
-            packet.setPriority("Medium");
-            if (mediumCount < maxQueueSize) {
-                mediumPriorityQueue.push(packet);
-                mediumCount++;
-            }
+    }
+    else if (qosClass == MEDIUM_PRIORITY) {
+        packet.setPriority("Medium");
+        if (mediumCount < maxQueueSize) {
+            packet.markEnqueued(now);
+            mediumPriorityQueue.push(packet);
+            mediumCount++;
+            return true;
         }
-        else {
-            packet.setPriority("Low");
-            if (lowCount < maxQueueSize) {
-                lowPriorityQueue.push(packet);
-                lowCount++;
-            }
+    }
+    else {
+        packet.setPriority("Low");
+        if (lowCount < maxQueueSize) {
+            packet.markEnqueued(now);
+            lowPriorityQueue.push(packet);
+            lowCount++;
+            return true;
         }
     }
+
+    classDropped[qosClass]++;
+    return false;
 }
 
 packets QoService::getNextPacket() {
+    return getNextPacket(Clock::now());
+}
+
+packets QoService::getNextPacket(long long now) {
     if (!highPriorityQueue.empty() && highCount > 0) {
         packets packet = highPriorityQueue.front();
         highPriorityQueue.pop();
+        recordDequeue(packet, now);
         highCount--;
         return packet;
     }
     else if (!mediumPriorityQueue.empty() && mediumCount > 0) {
         packets packet = mediumPriorityQueue.front();
         mediumPriorityQueue.pop();
+        recordDequeue(packet, now);
         mediumCount--;
         return packet;
     }
     else if (!lowPriorityQueue.empty() && lowCount > 0) {
         packets packet = lowPriorityQueue.front();
         lowPriorityQueue.pop();
+        recordDequeue(packet, now);
         lowCount--;
         return packet;
     }
@@ -138,6 +209,57 @@ void QoService::forwardOrDrop() {
     cout << "Forwarded: " << forwarded << ", Dropped: " << dropped << endl;
 }
 
+// Sojourn time is measured from the enqueue stamp taken in enqueuePacket.
+void QoService::recordDequeue(packets& packet, long long now) {
+    packet.markDequeued(now);
+    long long delay = packet.getQueueDelay();
+    totalQueueDelay += delay;
+    dequeuedCount++;
+
+    int qosClass = packet.getQosClass();
+    classQueueDelay[qosClass] += delay;
+    classDequeued[qosClass]++;
+    if (delay > classMaxQueueDelay[qosClass]) {
+        classMaxQueueDelay[qosClass] = delay;
+    }
+}
+
+long long QoService::getAverageQueueDelay() const {
+    if (dequeuedCount == 0) {
+        return 0;
+    }
+    return totalQueueDelay / dequeuedCount;
+}
+
+long long QoService::getAverageQueueDelay(int qosClass) const {
+    if (classDequeued[qosClass] == 0) {
+        return 0;
+    }
+    return classQueueDelay[qosClass] / classDequeued[qosClass];
+}
+
+long long QoService::getMaxQueueDelay(int qosClass) const {
+    return classMaxQueueDelay[qosClass];
+}
+
+long long QoService::getDequeuedCount(int qosClass) const {
+    return classDequeued[qosClass];
+}
+
+long long QoService::getDroppedCount(int qosClass) const {
+    return classDropped[qosClass];
+}
+
+void QoService::displayClassStats() const {
+    const char* names[] = { "High", "Medium", "Low" };
+    for (int qosClass = 0; qosClass < 3; qosClass++) {
+        cout << "  " << names[qosClass] << ": dequeued " << classDequeued[qosClass]
+            << ", dropped " << classDropped[qosClass]
+            << ", avg queue delay " << Clock::toMilliseconds(getAverageQueueDelay(qosClass)) << "ms"
+            << ", max " << Clock::toMilliseconds(classMaxQueueDelay[qosClass]) << "ms" << endl;
+    }
+}
+
 bool QoService::allQueuesEmpty() const {
     return highPriorityQueue.empty() && mediumPriorityQueue.empty() && lowPriorityQueue.empty();
 }
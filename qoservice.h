@@ -1,17 +1,25 @@
 #ifndef QOSERVICE_H
 #define QOSERVICE_H
 
+#include <deque>
 #include <iostream>
+#include <memory_resource>
 #include <queue>
 #include <string>
 #include <vector>
 #include "packets.h" 
+#include "FlowTable.h"
+#include "PacketClassifier.h"
 
+// Queued packets (and their strings) are allocated from the memory
+// resource given at construction.
 class QoService {
 private:
-    std::queue<packets> highPriorityQueue;
-    std::queue<packets> mediumPriorityQueue;
-    std::queue<packets> lowPriorityQueue;
+    typedef std::queue<packets, std::pmr::deque<packets>> PacketQueue;
+
+    PacketQueue highPriorityQueue;
+    PacketQueue mediumPriorityQueue;
+    PacketQueue lowPriorityQueue;
 
     int highCount;
     int mediumCount;
@@ -20,19 +28,53 @@ private:
     int maxQueueSize;
     bool forwardedStatus;
 
+    long long totalQueueDelay;
+    long long dequeuedCount;
+
+    long long classQueueDelay[3];
+    long long classMaxQueueDelay[3];
+    long long classDequeued[3];
+    long long classDropped[3];
+
+    FlowTable* flowTable;
+    const PacketClassifier* classifier;
+
+    void recordDequeue(packets& packet, long long now);
+    int classifyFlow(packets& packet, long long now);
+    int classifyPacket(const packets& packet) const;
+
 public:
-    QoService(int maxSize = 10);
+    enum QosClass { HIGH_PRIORITY = 0, MEDIUM_PRIORITY = 1, LOW_PRIORITY = 2 };
+
+    QoService(int maxSize = 10, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    QoService(const QoService& other) = default;
+    QoService(const QoService& other, std::pmr::memory_resource* resource);
+    QoService& operator=(const QoService& other) = default;
+
+    void setFlowTable(FlowTable* table);
+    void setClassifier(const PacketClassifier* rules);
+    int getMaxQueueSize() const;
+    int classifyPort(int port) const;
 
     std::vector<packets> readPacketsFromFile(const std::string& filename);
 
     void classifyPackets(const std::vector<packets>& packetVec);
+    bool enqueuePacket(packets& packet, long long now);
     void setForwardedStatus(bool ft);
     bool getForwardedStatus();
 
     packets getNextPacket();
+    packets getNextPacket(long long now);
 
     void forwardOrDrop();
 
+    long long getAverageQueueDelay() const;
+    long long getAverageQueueDelay(int qosClass) const;
+    long long getMaxQueueDelay(int qosClass) const;
+    long long getDequeuedCount(int qosClass) const;
+    long long getDroppedCount(int qosClass) const;
+    void displayClassStats() const;
+
     bool allQueuesEmpty() const;
     void displayQueueStatus() const;
 };